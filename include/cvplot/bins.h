@@ -0,0 +1,57 @@
+#ifndef CVPLOT_BINS_H
+#define CVPLOT_BINS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cvplot {
+
+// Histogram bin counts over raw samples, memory is O(bins). Log bins need
+// min > 0, auto bins start from the first batch and double their width to
+// fit later samples.
+class Bins {
+ public:
+  enum Mode {
+    Fixed,
+    Log,
+    Auto,
+  };
+
+  Bins(Mode mode, int count, double min, double max);
+
+  static auto fixed(int count, double min, double max) -> Bins;
+  static auto log(int count, double min, double max) -> Bins;
+  static auto automatic(int count) -> Bins;
+
+  auto add(double value) -> Bins &;
+  auto add(const double *values, size_t count) -> Bins &;
+  auto add(const std::vector<double> &values) -> Bins &;
+  auto clear() -> Bins &;
+
+  auto mode() const -> Mode;
+  auto size() const -> int;
+  auto count(int bin) const -> uint64_t;
+  auto lower(int bin) const -> double;
+  auto upper(int bin) const -> double;
+  auto center(int bin) const -> double;
+  auto underflow() const -> uint64_t;
+  auto overflow() const -> uint64_t;
+  auto total() const -> uint64_t;
+
+ protected:
+  void extend(double min, double max);
+  void collect(const double *values, size_t count,
+               std::vector<uint64_t> &counts) const;
+
+  Mode mode_;
+  double min_;
+  double max_;
+  double scale_;
+  std::vector<uint64_t> counts_;
+  bool empty_;
+};
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_BINS_H
@@ -0,0 +1,39 @@
+#ifndef CVPLOT_COLORMAP_H
+#define CVPLOT_COLORMAP_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "color.h"
+
+namespace cvplot {
+
+// Precomputed color lookup table, mapping a value range onto colors.
+class Colormap {
+ public:
+  Colormap(std::vector<Color> lut, bool cyclic = false)
+      : lut_(std::make_shared<const std::vector<Color>>(std::move(lut))),
+        cyclic_(cyclic) {}
+
+  auto size() const -> int { return static_cast<int>(lut_->size()); }
+  auto cyclic() const -> bool { return cyclic_; }
+  auto operator[](int index) const -> const Color & { return (*lut_)[index]; }
+  auto index(double value, double min, double max) const -> int;
+  auto color(double value, double min = 0., double max = 1.) const -> Color;
+  void map(const double *values, int count, int stride, double min,
+           double max, Color *colors) const;
+
+  static auto cos() -> const Colormap &;
+  static auto viridis() -> const Colormap &;
+  static auto magma() -> const Colormap &;
+  static auto turbo() -> const Colormap &;
+
+ protected:
+  std::shared_ptr<const std::vector<Color>> lut_;
+  bool cyclic_;
+};
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_COLORMAP_H
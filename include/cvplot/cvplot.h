@@ -1,9 +1,22 @@
 #ifndef CVPLOT_H
 #define CVPLOT_H
 
+#include "bins.h"
 #include "color.h"
+#include "colormap.h"
+#include "export.h"
+#include "feed.h"
 #include "figure.h"
 #include "highgui.h"
+#include "quantiles.h"
+#include "record.h"
+#include "typed.h"
 #include "window.h"
 
+// built on POSIX targets only
+#if defined(__unix__) || defined(__APPLE__)
+#include "server.h"
+#include "shared.h"
+#endif
+
 #endif  // CVPLOT_H
@@ -0,0 +1,34 @@
+#ifndef CVPLOT_EXPORT_H
+#define CVPLOT_EXPORT_H
+
+#include <future>
+#include <memory>
+#include <string>
+
+#include "figure.h"
+#include "window.h"
+
+namespace cvplot {
+
+// Writes figures to image files in the background. Figures are copied on
+// add, rendered on a pool of render threads and handed to a separate pool
+// that encodes and writes, so encoding never holds up drawing.
+class Exporter {
+ public:
+  Exporter(int renderers = 0, int writers = 0);
+  ~Exporter();
+
+  auto add(const Figure &figure, const std::string &filename, Size size,
+           const Encoding &encoding = Encoding::png()) -> std::future<bool>;
+  void wait();
+
+  auto operator=(const Exporter &) -> Exporter & = delete;
+
+ protected:
+  struct Queue;
+  std::unique_ptr<Queue> queue_;
+};
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_EXPORT_H
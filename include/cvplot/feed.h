@@ -0,0 +1,101 @@
+#ifndef CVPLOT_FEED_H
+#define CVPLOT_FEED_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace cvplot {
+
+// Lock-free single-producer, single-consumer queue of samples for a
+// series. One thread adds, the thread that owns the figure drains it with
+// Series::drain(). Adding never blocks; when the queue is full the sample
+// is dropped and counted.
+class Feed {
+ public:
+  struct Sample {
+    double key;
+    double values[3];  // NOLINT(modernize-avoid-c-arrays)
+    int count;
+    bool keyed;
+  };
+
+  explicit Feed(size_t capacity = 4096) {
+    auto size = static_cast<size_t>(1);
+    while (size < capacity) {
+      size <<= 1;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+
+  auto add(double key, double value) -> bool {
+    return push({key, {value, 0, 0}, 1, true});
+  }
+  auto add(double key, double value_a, double value_b) -> bool {
+    return push({key, {value_a, value_b, 0}, 2, true});
+  }
+  auto add(double key, double value_a, double value_b, double value_c)
+      -> bool {
+    return push({key, {value_a, value_b, value_c}, 3, true});
+  }
+  auto addValue(double value) -> bool {
+    return push({0, {value, 0, 0}, 1, false});
+  }
+  auto addValue(double value_a, double value_b) -> bool {
+    return push({0, {value_a, value_b, 0}, 2, false});
+  }
+  auto addValue(double value_a, double value_b, double value_c) -> bool {
+    return push({0, {value_a, value_b, value_c}, 3, false});
+  }
+
+  auto push(const Sample &sample) -> bool {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ > mask_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    slots_[tail & mask_] = sample;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  auto pop(Sample &sample) -> bool {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) {
+        return false;
+      }
+    }
+    sample = slots_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  auto capacity() const -> size_t { return mask_ + 1; }
+  auto dropped() const -> size_t {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  auto operator=(const Feed &) -> Feed & = delete;
+
+ protected:
+  // producer and consumer state on separate cache lines
+  std::vector<Sample> slots_;
+  size_t mask_;
+  char pad0_[64];  // NOLINT(modernize-avoid-c-arrays)
+  std::atomic<size_t> tail_{0};
+  size_t head_cache_{0};
+  std::atomic<size_t> dropped_{0};
+  char pad1_[64];  // NOLINT(modernize-avoid-c-arrays)
+  std::atomic<size_t> head_{0};
+  size_t tail_cache_{0};
+};
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_FEED_H
@@ -1,12 +1,22 @@
 #ifndef CVPLOT_FIGURE_H
 #define CVPLOT_FIGURE_H
 
+#include <cstdint>
+#include <deque>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "bins.h"
 #include "color.h"
+#include "colormap.h"
+#include "feed.h"
+#include "quantiles.h"
 #include "window.h"
 
 namespace cvplot {
@@ -23,6 +33,22 @@ struct Point3 {
   Point3(double x, double y, double z) : x(x), y(y), z(z) {}
 };
 
+// Values per entry for a value type, 1 for scalars.
+template <typename T>
+struct ValueDepth {
+  static const int value = 1;
+};
+
+template <>
+struct ValueDepth<Point2> {
+  static const int value = 2;
+};
+
+template <>
+struct ValueDepth<Point3> {
+  static const int value = 3;
+};
+
 enum Type {
   Line,
   DotLine,
@@ -37,20 +63,68 @@ enum Type {
   Circle,
 };
 
+// Anti-aliased drawing or plain 8-connected lines and fills.
+enum Quality {
+  Smooth,
+  Fast,
+};
+
+// Values per entry for a series type, without a dynamic color.
+template <enum Type T>
+struct TypeDepth {
+  static const int value =
+      (T == RangeLine ? 3 : (T == Range || T == Circle) ? 2 : 1);
+};
+
+template <enum Type T, bool Dynamic, enum Quality Q>
+struct Kernel;
+template <enum Type T, bool DynamicColor>
+class TypedSeries;
+
+// Feeds of a series. A feed has a single consumer, the thread draining the
+// series that made it, so copies of a series start without feeds.
+class Feeds {
+ public:
+  Feeds() = default;
+  Feeds(const Feeds & /*other*/) {}
+  auto operator=(const Feeds & /*other*/) -> Feeds & { return *this; }
+
+  auto add(size_t capacity) -> std::shared_ptr<Feed> {
+    feeds_.push_back(std::make_shared<Feed>(capacity));
+    return feeds_.back();
+  }
+  auto begin() const -> std::vector<std::shared_ptr<Feed>>::const_iterator {
+    return feeds_.begin();
+  }
+  auto end() const -> std::vector<std::shared_ptr<Feed>>::const_iterator {
+    return feeds_.end();
+  }
+
+ protected:
+  std::vector<std::shared_ptr<Feed>> feeds_;
+};
+
 class Series {
  public:
   Series(std::string label, enum Type type, Color color)
       : label_(std::move(label)),
         type_(type),
         color_(color),
+        colormap_(Colormap::cos()),
+        color_min_(0.),
+        color_max_(6.),
         dims_(0),
         depth_(0),
         legend_(true),
-        dynamic_color_(false) {}
+        dynamic_color_(false),
+        quality_(Smooth) {}
 
   auto type(enum Type type) -> Series &;
   auto color(Color color) -> Series &;
   auto dynamicColor(bool dynamic_color) -> Series &;
+  auto quality(enum Quality quality) -> Series &;
+  auto colormap(const Colormap &colormap, double min = 0., double max = 1.)
+      -> Series &;
   auto legend(bool legend) -> Series &;
   auto add(const std::vector<std::pair<double, double>> &data) -> Series &;
   auto add(const std::vector<std::pair<double, Point2>> &data) -> Series &;
@@ -77,9 +151,35 @@ class Series {
   auto setValue(double value) -> Series &;
   auto setValue(double value_a, double value_b) -> Series &;
   auto setValue(double value_a, double value_b, double value_c) -> Series &;
+  auto set(const Bins &bins) -> Series &;
+  auto set(const Quantiles &quantiles, double lower, double upper)
+      -> Series &;
   auto clear() -> Series &;
+  auto reserve(size_t count) -> Series &;
+
+  // Bulk adds straight into series storage, growing it once. Elements (or
+  // what `project` returns for them) are key-value pairs for addRange and
+  // values for addValueRange, where a value is a number, Point2 or Point3.
+  template <typename Iterator>
+  auto addRange(Iterator first, Iterator last) -> Series &;
+  template <typename Iterator, typename Projection>
+  auto addRange(Iterator first, Iterator last, Projection project)
+      -> Series &;
+  template <typename Iterator>
+  auto addValueRange(Iterator first, Iterator last) -> Series &;
+  template <typename Iterator, typename Projection>
+  auto addValueRange(Iterator first, Iterator last, Projection project)
+      -> Series &;
+  template <typename Container>
+  auto addValues(const Container &values) -> Series &;
+  template <typename Container, typename Projection>
+  auto addValues(const Container &values, Projection project) -> Series &;
+
+  auto feed(size_t capacity = 4096) -> std::shared_ptr<Feed>;
+  auto drain() -> Series &;
 
   auto label() const -> const std::string &;
+  auto size() const -> size_t;
   auto legend() const -> bool;
   auto color() const -> Color;
   void draw(void *buffer, double x_min, double x_max, double y_min,
@@ -94,17 +194,169 @@ class Series {
  protected:
   void ensureDimsDepth(int dims, int depth);
   auto flipAxis() const -> bool;
+  // bounds of x and y columns in one pass, a count of 0 skips a side
+  void columnBounds(int x_first, int x_count, double &x_min, double &x_max,
+                    int y_first, int y_count, double &y_min,
+                    double &y_max) const;
+  void dynamicColors(std::vector<Color> &colors) const;
+
+  template <enum Type T, bool Dynamic, enum Quality Q>
+  friend struct Kernel;
+  template <enum Type T, bool DynamicColor>
+  friend class TypedSeries;
+
+  struct Identity {
+    template <typename T>
+    auto operator()(const T &value) const -> const T & {
+      return value;
+    }
+  };
+
+  template <typename T>
+  static void store(double *data, const T &value) {
+    data[0] = static_cast<double>(value);
+  }
+  static void store(double *data, const Point2 &value) {
+    data[0] = value.x;
+    data[1] = value.y;
+  }
+  static void store(double *data, const Point3 &value) {
+    data[0] = value.x;
+    data[1] = value.y;
+    data[2] = value.z;
+  }
 
  protected:
   std::vector<int> entries_;
   std::vector<double> data_;
+  Feeds feeds_;
   enum Type type_;
   Color color_;
+  Colormap colormap_;
+  double color_min_;
+  double color_max_;
   std::string label_;
   int dims_;
   int depth_;
   bool legend_;
   bool dynamic_color_;
+  enum Quality quality_;
+};
+
+template <typename Iterator>
+auto Series::addRange(Iterator first, Iterator last) -> Series & {
+  return addRange(first, last, Identity());
+}
+
+template <typename Iterator, typename Projection>
+auto Series::addRange(Iterator first, Iterator last, Projection project)
+    -> Series & {
+  typedef typename std::decay<decltype(project(*first).second)>::type Value;
+  const auto stride = 1 + ValueDepth<Value>::value;
+  ensureDimsDepth(1, ValueDepth<Value>::value);
+  auto count = static_cast<size_t>(std::distance(first, last));
+  auto entry = entries_.size();
+  auto offset = data_.size();
+  entries_.resize(entry + count);
+  data_.resize(offset + count * stride);
+  auto *e = entries_.data() + entry;
+  auto *d = data_.data() + offset;
+  for (size_t i = 0; i < count; i++, ++first, d += stride) {
+    const auto &pair = project(*first);
+    e[i] = static_cast<int>(offset + i * stride);
+    d[0] = static_cast<double>(pair.first);
+    store(d + 1, pair.second);
+  }
+  return *this;
+}
+
+template <typename Iterator>
+auto Series::addValueRange(Iterator first, Iterator last) -> Series & {
+  return addValueRange(first, last, Identity());
+}
+
+template <typename Iterator, typename Projection>
+auto Series::addValueRange(Iterator first, Iterator last, Projection project)
+    -> Series & {
+  typedef typename std::decay<decltype(project(*first))>::type Value;
+  const auto stride = 1 + ValueDepth<Value>::value;
+  ensureDimsDepth(1, ValueDepth<Value>::value);
+  auto count = static_cast<size_t>(std::distance(first, last));
+  auto entry = entries_.size();
+  auto offset = data_.size();
+  entries_.resize(entry + count);
+  data_.resize(offset + count * stride);
+  auto *e = entries_.data() + entry;
+  auto *d = data_.data() + offset;
+  for (size_t i = 0; i < count; i++, ++first, d += stride) {
+    e[i] = static_cast<int>(offset + i * stride);
+    d[0] = static_cast<double>(entry + i);
+    store(d + 1, project(*first));
+  }
+  return *this;
+}
+
+template <typename Container>
+auto Series::addValues(const Container &values) -> Series & {
+  return addValueRange(std::begin(values), std::end(values), Identity());
+}
+
+template <typename Container, typename Projection>
+auto Series::addValues(const Container &values, Projection project)
+    -> Series & {
+  return addValueRange(std::begin(values), std::end(values), project);
+}
+
+// Counts clears of a figure, in a counter that outlives it, so handles can
+// tell their series is gone. A copy of a figure gets its own counter.
+class Generation {
+ public:
+  Generation() : count_(std::make_shared<size_t>(0)) {}
+  Generation(const Generation & /*other*/) : Generation() {}
+  ~Generation() { next(); }
+
+  void next() { ++*count_; }
+  auto counter() const -> std::shared_ptr<const size_t> { return count_; }
+
+  auto operator=(const Generation &) -> Generation & = delete;
+
+ protected:
+  std::shared_ptr<size_t> count_;
+};
+
+// Refers to a series of a figure without a label lookup. Cheap to copy and
+// stays valid as series are added, until the figure is cleared or
+// destroyed.
+class SeriesHandle {
+ public:
+  SeriesHandle() : series_(nullptr), expected_(0) {}
+  SeriesHandle(Series &series, std::shared_ptr<const size_t> generation)
+      : series_(&series),
+        generation_(std::move(generation)),
+        expected_(*generation_) {}
+
+  auto operator->() const -> Series * { return series_; }
+  auto operator*() const -> Series & { return *series_; }
+  auto valid() const -> bool {
+    return series_ != nullptr && *generation_ == expected_;
+  }
+
+ protected:
+  Series *series_;
+  std::shared_ptr<const size_t> generation_;
+  size_t expected_;
+};
+
+// Timings of the stages of drawing a figure. Compositing of transparent
+// layers, including those of each series, happens within the other stages
+// and is also counted there.
+struct FigureStats {
+  Timing bounds;   // drawFit finding the value range
+  Timing grid;     // background, grid, tick labels and axes
+  Timing series;   // all series
+  Timing legend;   // labels and their dots
+  Timing compose;  // blending transparent layers
+  Timing draw;     // all of the above, per draw
 };
 
 class Figure {
@@ -120,9 +372,11 @@ class Figure {
         include_zero_y_(true),
         aspect_square_(false),
         grid_size_(60),
-        grid_padding_(20) {}
+        grid_padding_(20),
+        hud_(false) {}
 
   auto clear() -> Figure &;
+  auto drain() -> Figure &;
   auto origin(bool x, bool y) -> Figure &;
   auto square(bool square) -> Figure &;
   auto border(int size) -> Figure &;
@@ -132,6 +386,8 @@ class Figure {
   auto axisColor(Color color) -> Figure &;
   auto subaxisColor(Color color) -> Figure &;
   auto textColor(Color color) -> Figure &;
+  // overlays the timings of the previous draw in the plot corner
+  auto hud(bool hud) -> Figure &;
   auto backgroundColor() -> Color;
   auto axisColor() -> Color;
   auto subaxisColor() -> Color;
@@ -141,12 +397,22 @@ class Figure {
             double y_max, int n_max, int p_max) const;
   auto drawFit(void *buffer) const -> int;
   auto drawFile(const std::string &filename, Size size) const -> bool;
+  auto drawFile(const std::string &filename, Size size,
+                const Encoding &encoding) const -> bool;
+  auto drawBytes(std::vector<uint8_t> &bytes, Size size,
+                 const Encoding &encoding = Encoding::png()) const -> bool;
+  auto drawRaw(uint8_t *bgr, Size size, int stride = 0) const -> bool;
   void show(bool flush = true) const;
   auto series(const std::string &label) -> Series &;
+  auto handle(const std::string &label) -> SeriesHandle;
+  // timings of past draws, which every draw updates: concurrent draws of
+  // one figure need a lock like any other concurrent use
+  auto stats() const -> const FigureStats & { return stats_; }
 
  protected:
   View &view_;
-  std::vector<Series> series_;
+  std::deque<Series> series_;  // stable, for handles
+  std::unordered_map<std::string, size_t> index_;
   int border_size_;
   Color background_color_;
   Color axis_color_;
@@ -157,8 +423,13 @@ class Figure {
   bool aspect_square_;
   int grid_size_;
   int grid_padding_;
+  bool hud_;
+  mutable FigureStats stats_;
+  Generation generation_;
 };
 
+// Shared figure by name, safe to call from any thread. The reference stays
+// valid for the life of the program, so hot paths can keep it.
 auto figure(const std::string &name) -> Figure &;
 
 }  // namespace cvplot
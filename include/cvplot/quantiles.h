@@ -0,0 +1,73 @@
+#ifndef CVPLOT_QUANTILES_H
+#define CVPLOT_QUANTILES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace cvplot {
+
+// Mergeable t-digest quantile sketch. Memory is bounded by the compression,
+// inserts are buffered and merged in batches.
+class Digest {
+ public:
+  Digest(double compression = 100.);
+
+  auto add(double value, double weight = 1.) -> Digest &;
+  auto merge(const Digest &other) -> Digest &;
+  auto clear() -> Digest &;
+  auto quantile(double q) const -> double;
+  auto count() const -> double;
+  auto min() const -> double;
+  auto max() const -> double;
+  auto centroids() const -> size_t;
+
+ protected:
+  struct Centroid {
+    double mean, weight;
+  };
+
+  void compress() const;
+
+  double compression_;
+  double min_;
+  double max_;
+  mutable double total_;
+  mutable std::vector<Centroid> merged_;
+  mutable std::vector<Centroid> buffer_;
+};
+
+// Quantile sketches over time, one digest per fixed-width time bucket.
+class Quantiles {
+ public:
+  Quantiles(double width = 1., double compression = 100.)
+      : width_(width),
+        compression_(compression),
+        last_(buckets_.end()),
+        discard_(compression) {}
+  Quantiles(const Quantiles &other);
+  auto operator=(const Quantiles &other) -> Quantiles &;
+
+  auto add(double time, double value) -> Quantiles &;
+  auto merge(const Quantiles &other) -> Quantiles &;
+  auto limit(size_t count) -> Quantiles &;
+  auto clear() -> Quantiles &;
+  // samples at a non-finite time, or older than every retained bucket
+  // when limited, go to a scratch digest that is emptied on each use
+  auto bucket(double time) -> Digest &;
+  auto buckets() const -> const std::map<int64_t, Digest> &;
+  auto width() const -> double;
+
+ protected:
+  double width_;
+  double compression_;
+  size_t limit_{0};
+  std::map<int64_t, Digest> buckets_;
+  std::map<int64_t, Digest>::iterator last_;
+  Digest discard_;
+};
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_QUANTILES_H
@@ -0,0 +1,49 @@
+#ifndef CVPLOT_RECORD_H
+#define CVPLOT_RECORD_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "figure.h"
+#include "window.h"
+
+namespace cvplot {
+
+// Streams frames to a video file, either MJPG in AVI through OpenCV or
+// raw Y4M. Frames are copied into a bounded queue and encoded on a
+// background thread; when the queue is full the drop policy decides.
+// All frames are scaled to the size of the first one.
+class Recorder : public Sink {
+ public:
+  enum Format {
+    Mjpg,
+    Y4m,
+  };
+
+  enum Drop {
+    DropOldest,
+    DropNewest,
+    Block,
+  };
+
+  Recorder(const std::string &filename, double fps = 30., Format format = Mjpg,
+           size_t capacity = 8, Drop drop = DropOldest);
+  ~Recorder() override;
+
+  void write(const void *frame) override;
+  auto add(const Figure &figure, Size size) -> Recorder &;
+  void close();
+  auto written() const -> size_t;
+  auto dropped() const -> size_t;
+
+  auto operator=(const Recorder &) -> Recorder & = delete;
+
+ protected:
+  struct Encoder;
+  std::unique_ptr<Encoder> encoder_;
+};
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_RECORD_H
@@ -0,0 +1,39 @@
+#ifndef CVPLOT_SERVER_H
+#define CVPLOT_SERVER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "figure.h"
+#include "window.h"
+
+namespace cvplot {
+
+// Serves the latest frame over HTTP: `/stream` as MJPEG and `/snapshot` as
+// a single JPEG. Both take `scale` (0-1) and `/stream` takes `fps` to cap
+// the rate. Each frame is encoded once per scale and shared by all clients.
+// A port of 0 picks a free one, see port(). Built on POSIX targets only.
+class Server : public Sink {
+ public:
+  Server(int port = 8080, const std::string &host = "127.0.0.1",
+         int quality = 80);
+  ~Server() override;
+
+  void write(const void *frame) override;
+  auto add(const Figure &figure, Size size) -> Server &;
+  void close();
+  auto port() const -> int;
+  auto clients() const -> size_t;
+  auto encoded() const -> size_t;
+
+  auto operator=(const Server &) -> Server & = delete;
+
+ protected:
+  struct Http;
+  std::unique_ptr<Http> http_;
+};
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_SERVER_H
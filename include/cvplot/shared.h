@@ -0,0 +1,80 @@
+#ifndef CVPLOT_SHARED_H
+#define CVPLOT_SHARED_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "window.h"
+
+namespace cvplot {
+
+// Publishes frames into a POSIX shared memory ring so a viewer process can
+// map them without copies. The memory starts with a Header, followed by
+// `slots` fixed-size slots, each a Frame header followed by BGR pixels.
+// A frame is consistent if its sequence is unchanged after reading it.
+// Built on POSIX targets only.
+class SharedRing : public Sink {
+ public:
+  struct Header {
+    char magic[8];  // NOLINT(modernize-avoid-c-arrays)
+    uint32_t version;
+    uint32_t slots;
+    uint64_t slot_size;
+    std::atomic<uint64_t> sequence;  // last published frame, 0 if none
+  };
+
+  struct Frame {
+    std::atomic<uint64_t> sequence;  // 0 while being written
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t channels;
+    uint64_t size;
+    int64_t timestamp;  // steady clock, nanoseconds
+    uint8_t reserved[24];  // NOLINT(modernize-avoid-c-arrays)
+    // pixels follow, starting on a cache line
+    auto pixels() const -> const uint8_t * {
+      return reinterpret_cast<const uint8_t *>(this) + sizeof(Frame);
+    }
+  };
+
+  SharedRing(const std::string &name, Size max_size, int slots = 3);
+  ~SharedRing() override;
+
+  void write(const void *frame) override;
+  auto valid() const -> bool;
+  auto sequence() const -> uint64_t;
+
+  auto operator=(const SharedRing &) -> SharedRing & = delete;
+
+ protected:
+  std::string name_;
+  void *memory_;
+  size_t bytes_;
+  size_t slot_bytes_;
+  Size max_size_;
+};
+
+// Maps a SharedRing read-only from another process (or the same one).
+class SharedReader {
+ public:
+  SharedReader(const std::string &name);
+  ~SharedReader();
+
+  auto valid() const -> bool;
+  auto latest(uint64_t &sequence) const -> const SharedRing::Frame *;
+  auto current(const SharedRing::Frame &frame, uint64_t sequence) const
+      -> bool;
+
+  auto operator=(const SharedReader &) -> SharedReader & = delete;
+
+ protected:
+  const void *memory_;
+  size_t bytes_;
+};
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_SHARED_H
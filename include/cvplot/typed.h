@@ -0,0 +1,74 @@
+#ifndef CVPLOT_TYPED_H
+#define CVPLOT_TYPED_H
+
+#include <cstddef>
+
+#include "figure.h"
+
+namespace cvplot {
+
+// A series with its type, depth and dynamic color fixed at compile time.
+// Wraps a Series of a figure, setting its layout once; adds then write
+// straight into storage with no layout checks, and the series draws with
+// the kernel compiled for T and DynamicColor.
+template <enum Type T, bool DynamicColor = false>
+class TypedSeries {
+ public:
+  static const int depth = TypeDepth<T>::value + (DynamicColor ? 1 : 0);
+  static const int stride = 1 + depth;
+
+  explicit TypedSeries(Series &series) : series_(&series) {
+    if (series.dims_ != 1 || series.depth_ != depth) {
+      series.clear();
+    }
+    series.type(T).dynamicColor(DynamicColor);
+    series.dims_ = 1;
+    series.depth_ = depth;
+  }
+  explicit TypedSeries(SeriesHandle handle) : TypedSeries(*handle) {}
+
+  template <typename... Values>
+  auto add(double key, Values... values) -> TypedSeries & {
+    static_assert(sizeof...(Values) == depth,
+                  "value count must match the series depth");
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
+    const double entry[stride] = {key, static_cast<double>(values)...};
+    auto &s = *series_;
+    s.entries_.push_back(static_cast<int>(s.data_.size()));
+    s.data_.insert(s.data_.end(), entry, entry + stride);
+    return *this;
+  }
+
+  template <typename... Values>
+  auto addValue(Values... values) -> TypedSeries & {
+    return add(static_cast<double>(series_->entries_.size()), values...);
+  }
+
+  auto reserve(size_t count) -> TypedSeries & {
+    series_->entries_.reserve(count);
+    series_->data_.reserve(count * stride);
+    return *this;
+  }
+
+  // keeps the layout, unlike Series::clear
+  auto clear() -> TypedSeries & {
+    series_->entries_.clear();
+    series_->data_.clear();
+    return *this;
+  }
+
+  auto size() const -> size_t { return series_->entries_.size(); }
+  auto series() const -> Series & { return *series_; }
+
+ protected:
+  Series *series_;
+};
+
+template <enum Type T, bool DynamicColor>
+const int TypedSeries<T, DynamicColor>::depth;
+template <enum Type T, bool DynamicColor>
+const int TypedSeries<T, DynamicColor>::stride;
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_TYPED_H
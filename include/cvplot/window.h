@@ -1,9 +1,14 @@
 #ifndef CVPLOT_WINDOW_H
 #define CVPLOT_WINDOW_H
 
+#include <chrono>
+#include <cstddef>
+#include <functional>
 #include <map>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "color.h"
 
@@ -25,11 +30,56 @@ struct Offset {
   Offset(int x, int y) : x(x), y(y) {}
 };
 
+struct Encoding {
+  enum Format {
+    Png,
+    Jpeg,
+    Ppm,
+    Bmp,
+  };
+  Format format;
+  int level;  // png compression 0-9, jpeg quality 0-100
+  Encoding(Format format, int level = 0) : format(format), level(level) {}
+
+  static auto png(int compression = 9) -> Encoding {
+    return {Png, compression};
+  }
+  static auto jpeg(int quality = 95) -> Encoding { return {Jpeg, quality}; }
+  static auto ppm() -> Encoding { return {Ppm}; }
+  static auto bmp() -> Encoding { return {Bmp}; }
+};
+
+// Time spent in one render stage, in seconds: the last run, a moving
+// average, the slowest run and the number of runs.
+struct Timing {
+  double last{0};
+  double average{0};
+  double max{0};
+  size_t count{0};
+
+  void add(double seconds);
+};
+
+struct WindowStats {
+  Timing finish;  // View::finish, frames and titles
+  Timing flush;   // presenting a frame: sinks, hand-off and show
+  Timing show;    // imshow, on the UI thread when async
+  Timing compose;  // blending transparent view draws, per presented frame
+};
+
 using MouseCallback = void (*)(int, int, int, int, void *);
 using TrackbarCallback = void (*)(int, void *);
 
 class Window;
 
+// Receives each frame a window flushes. The frame is a cv::Mat pointer,
+// valid for the duration of the call only.
+class Sink {
+ public:
+  virtual ~Sink() = default;
+  virtual void write(const void *frame) = 0;
+};
+
 class View {
  public:
   View(Window &window, std::string title = "", Size size = {300, 300})
@@ -76,6 +126,7 @@ class View {
   auto operator=(const View &) -> View & = delete;
 
  protected:
+  friend class Window;
   Rect rect_;
   std::string title_;
   bool frameless_;
@@ -90,38 +141,80 @@ class View {
 
 class Window {
  public:
-  Window(std::string title = "");
+  Window(std::string title = "", bool headless = false);
+  Window(const Window &) = delete;
   ~Window();
   auto resize(Rect rect) -> Window &;
   auto size(Size size) -> Window &;
+  auto reserve(Size size) -> Window &;
   auto offset(Offset offset) -> Window &;
   auto title(const std::string &title) -> Window &;
   auto ensure(Rect rect) -> Window &;
+  // draws a cursor, redrawn as the mouse moves on the next flush, or by the
+  // UI thread when async
   auto cursor(bool cursor) -> Window &;
+  // caps presentation; a frame flushed too early is held, and shown once
+  // due by an async window, or otherwise by the next flush past the
+  // interval or update()
+  auto fps(double fps) -> Window &;
+  // presents from a UI thread that owns HighGUI; mouse callbacks then run
+  // on that thread
+  auto async(bool async) -> Window &;
+  auto addSink(Sink &sink) -> Window &;
+  auto removeSink(Sink &sink) -> Window &;
   auto buffer() -> void *;
+  auto capacity() const -> Size;
   void flush();
+  void update();
+  // safe to call from any thread; drawing into a view is not
   auto view(const std::string &name, Size size = {300, 300}) -> View &;
   void dirty();
   void hide(bool hidden = true);
   void onmouse(int event, int x, int y, int flags);
   auto name() const -> const std::string & { return name_; }
+  auto headless() const -> bool { return headless_; }
+  auto fps() const -> double { return fps_; }
+  auto async() const -> bool { return presenter_ != nullptr; }
+  auto stats() const -> WindowStats;
 
   auto operator=(const Window &) -> Window & = delete;
 
   static auto current() -> Window &;
   static void current(Window &window);
-  static auto current(const std::string &title) -> Window &;
+  static auto current(const std::string &title, bool headless = false)
+      -> Window &;
 
  protected:
+  friend class View;
+  struct Presenter;
+
+  void show(void *buffer, const std::string &title, bool cursor);
+  void present();
+  void hand(std::chrono::steady_clock::time_point due);
+  void gui(const std::function<void()> &command);
+  void create();
+  void target();
+  void run();
+
   Offset offset_;
-  void *buffer_{nullptr};
+  void *buffer_{nullptr};   // view into storage_
+  void *storage_{nullptr};  // grows geometrically, never shrinks
   std::string title_;
   std::string name_;
   std::map<std::string, View> views_;
+  std::mutex views_mutex_;  // views are added from any thread, see view()
+  std::vector<Sink *> sinks_;
   bool dirty_{false};
   bool hidden_{false};
   bool show_cursor_{false};
+  bool cursor_moved_{false};  // since the last frame shown
+  bool headless_;
   Offset cursor_;
+  double fps_{0};
+  std::chrono::steady_clock::time_point next_frame_;
+  Presenter *presenter_{nullptr};
+  WindowStats stats_;
+  double composed_{0};  // view blending since the last presented frame
 };
 
 class Util {
@@ -129,6 +222,7 @@ class Util {
   static void sleep(double seconds = 0);
   static auto key(double timeout = 0) -> int;
   static auto line(double timeout = 0) -> std::string;
+  static auto allocations() -> size_t;  // of scratch buffers, all threads
 };
 
 auto window(const std::string &name) -> Window &;
@@ -0,0 +1,193 @@
+#include "cvplot/bins.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <thread>
+
+namespace cvplot {
+
+namespace {
+
+// batches smaller than this are binned on the calling thread
+constexpr size_t parallel_threshold = 1 << 16;
+
+}  // namespace
+
+Bins::Bins(Mode mode, int count, double min, double max)
+    : mode_(mode),
+      min_(mode == Log ? std::log(min) : min),
+      max_(mode == Log ? std::log(max) : max),
+      scale_(0.),
+      counts_(std::max(1, count) + 2, 0),
+      empty_(true) {
+  scale_ = (max_ > min_ ? size() / (max_ - min_) : 0.);
+}
+
+auto Bins::fixed(int count, double min, double max) -> Bins {
+  return {Fixed, count, min, max};
+}
+
+auto Bins::log(int count, double min, double max) -> Bins {
+  return {Log, count, min, max};
+}
+
+auto Bins::automatic(int count) -> Bins {
+  // merging pairs of bins when growing needs an even count
+  return {Auto, std::max(2, count + count % 2), 0., 1.};
+}
+
+auto Bins::add(double value) -> Bins & { return add(&value, 1); }
+
+auto Bins::add(const std::vector<double> &values) -> Bins & {
+  return add(values.data(), values.size());
+}
+
+auto Bins::add(const double *values, size_t count) -> Bins & {
+  if (count == 0) {
+    return *this;
+  }
+  if (mode_ == Auto) {
+    double lo = INFINITY;
+    double hi = -INFINITY;
+    for (size_t i = 0; i < count; i++) {
+      if (std::isfinite(values[i])) {
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+      }
+    }
+    if (lo <= hi) {
+      extend(lo, hi);
+    }
+  }
+  auto threads = std::min<size_t>(std::thread::hardware_concurrency(),
+                                  count / (parallel_threshold / 2));
+  if (count < parallel_threshold || threads < 2) {
+    collect(values, count, counts_);
+    return *this;
+  }
+  std::vector<std::vector<uint64_t>> partials(
+      threads, std::vector<uint64_t>(counts_.size(), 0));
+  std::vector<std::thread> workers;
+  auto chunk = (count + threads - 1) / threads;
+  for (size_t t = 0; t < threads; t++) {
+    auto begin = std::min(count, t * chunk);
+    auto end = std::min(count, begin + chunk);
+    workers.emplace_back([this, values, begin, end, &partials, t] {
+      collect(values + begin, end - begin, partials[t]);
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+  for (const auto &p : partials) {
+    for (size_t i = 0; i < counts_.size(); i++) {
+      counts_[i] += p[i];
+    }
+  }
+  return *this;
+}
+
+auto Bins::clear() -> Bins & {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  if (mode_ == Auto) {
+    empty_ = true;
+  }
+  return *this;
+}
+
+auto Bins::mode() const -> Mode { return mode_; }
+
+auto Bins::size() const -> int {
+  return static_cast<int>(counts_.size()) - 2;
+}
+
+auto Bins::count(int bin) const -> uint64_t { return counts_[bin + 1]; }
+
+auto Bins::lower(int bin) const -> double {
+  auto edge = min_ + bin / scale_;
+  return (mode_ == Log ? std::exp(edge) : edge);
+}
+
+auto Bins::upper(int bin) const -> double { return lower(bin + 1); }
+
+auto Bins::center(int bin) const -> double {
+  auto edge = min_ + (bin + .5) / scale_;
+  return (mode_ == Log ? std::exp(edge) : edge);
+}
+
+auto Bins::underflow() const -> uint64_t { return counts_.front(); }
+
+auto Bins::overflow() const -> uint64_t { return counts_.back(); }
+
+auto Bins::total() const -> uint64_t {
+  uint64_t total = 0;
+  for (auto c : counts_) {
+    total += c;
+  }
+  return total;
+}
+
+// grows the auto range by doubling the bin width until [min, max] fits,
+// merging neighbouring bin pairs so existing counts stay exact
+void Bins::extend(double min, double max) {
+  auto n = size();
+  if (empty_) {
+    auto width = (max > min ? (max - min) / (n - 1) : 1.);
+    min_ = min;
+    max_ = min + width * n;
+    scale_ = n / (max_ - min_);
+    empty_ = false;
+    return;
+  }
+  while (min < min_ || max >= max_) {
+    auto up = (max >= max_);
+    auto half = n / 2;
+    std::vector<uint64_t> merged(counts_.size(), 0);
+    merged.front() = counts_.front();
+    merged.back() = counts_.back();
+    for (auto i = 0; i < half; i++) {
+      merged[(up ? 0 : half) + i + 1] =
+          counts_[2 * i + 1] + counts_[2 * i + 2];
+    }
+    counts_.swap(merged);
+    if (up) {
+      max_ = min_ + 2 * (max_ - min_);
+    } else {
+      min_ = max_ - 2 * (max_ - min_);
+    }
+    scale_ = n / (max_ - min_);
+  }
+}
+
+void Bins::collect(const double *values, size_t count,
+                   std::vector<uint64_t> &counts) const {
+  const auto n = static_cast<double>(size());
+  std::array<int, 256> block{};
+  for (size_t begin = 0; begin < count; begin += block.size()) {
+    auto end = std::min(count, begin + block.size());
+    // slot pass is branch-free on the value so it vectorizes, NaN gets -1
+    if (mode_ == Log) {
+      for (auto i = begin; i < end; i++) {
+        auto v = values[i];
+        auto t = ((v > 0 ? std::log(v) : -INFINITY) - min_) * scale_;
+        auto slot = std::min(std::max(-1., std::floor(t)), n) + 1;
+        block[i - begin] = (t == t ? static_cast<int>(slot) : -1);
+      }
+    } else {
+      for (auto i = begin; i < end; i++) {
+        auto t = (values[i] - min_) * scale_;
+        auto slot = std::min(std::max(-1., std::floor(t)), n) + 1;
+        block[i - begin] = (t == t ? static_cast<int>(slot) : -1);
+      }
+    }
+    for (auto i = begin; i < end; i++) {
+      auto slot = block[i - begin];
+      if (slot >= 0) {
+        counts[slot]++;
+      }
+    }
+  }
+}
+
+}  // namespace cvplot
@@ -0,0 +1,136 @@
+#include "cvplot/colormap.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace cvplot {
+
+namespace {
+
+using Coeffs = std::array<std::array<double, 3>, 7>;
+
+// 6th order polynomial fits of the matplotlib maps (mattz, CC0)
+const Coeffs viridis_coeffs = {{
+    {{0.2777273272234177, 0.005407344544966578, 0.3340998053353061}},
+    {{0.1050930431085774, 1.404613529898575, 1.384590162594685}},
+    {{-0.3308618287255563, 0.214847559468213, 0.09509516302823659}},
+    {{-4.634230498983486, -5.799100973351585, -19.33244095627987}},
+    {{6.228269936347081, 14.17993336680509, 56.69055260068105}},
+    {{4.776384997670288, -13.74514537774601, -65.35303263337234}},
+    {{-5.435455855934631, 4.645852612178535, 26.3124352495832}},
+}};
+
+const Coeffs magma_coeffs = {{
+    {{-0.002136485053939582, -0.000749655052795221, -0.005386127855323933}},
+    {{0.2516605407371642, 0.6775232436837668, 2.494026599312351}},
+    {{8.353717279216625, -3.577719514958484, 0.3144679030132573}},
+    {{-27.66873308576866, 14.26473078096533, -13.64921318813922}},
+    {{52.17613981234068, -27.94360607168351, 12.94416944238394}},
+    {{-50.76852536473588, 29.04658282127291, 4.23415299384598}},
+    {{18.65570506591883, -11.48977351997711, -5.601961508734096}},
+}};
+
+// 5th order polynomial fit of Google's turbo map (Apache 2.0)
+const Coeffs turbo_coeffs = {{
+    {{0.13572138, 0.09140261, 0.10667330}},
+    {{4.61539260, 2.19418839, 12.64194608}},
+    {{-42.66032258, 4.84296658, -60.58204836}},
+    {{132.13108234, -14.18503333, 110.36276771}},
+    {{-152.94239396, 4.27729857, -89.90310912}},
+    {{59.28637943, 2.82956604, 27.34824973}},
+    {{0., 0., 0.}},
+}};
+
+auto channel(double v) -> uint8_t {
+  return static_cast<uint8_t>(std::min(1., std::max(0., v)) * 255 + .5);
+}
+
+auto polynomial(const Coeffs &coeffs, int size) -> std::vector<Color> {
+  std::vector<Color> lut(size);
+  for (auto i = 0; i < size; i++) {
+    auto t = i / static_cast<double>(size - 1);
+    std::array<double, 3> rgb = {{0., 0., 0.}};
+    for (auto c = coeffs.rbegin(); c != coeffs.rend(); ++c) {
+      for (auto j = 0; j < 3; j++) {
+        rgb[j] = rgb[j] * t + (*c)[j];
+      }
+    }
+    lut[i] = {channel(rgb[0]), channel(rgb[1]), channel(rgb[2])};
+  }
+  return lut;
+}
+
+// fractional lut position, written without branches on the value so the
+// loops in map() vectorize; NaN ends up at index 0
+inline auto position(double t, int size, bool cyclic) -> double {
+  if (cyclic) {
+    t = (t - std::floor(t)) * size;
+    return std::min(std::max(0., t), size - 1.);
+  }
+  return std::min(std::max(0., t), 1.) * (size - 1) + .5;
+}
+
+}  // namespace
+
+auto Colormap::index(double value, double min, double max) const -> int {
+  auto scale = (max != min ? 1. / (max - min) : 0.);
+  return static_cast<int>(position((value - min) * scale, size(), cyclic_));
+}
+
+auto Colormap::color(double value, double min, double max) const -> Color {
+  return (*lut_)[index(value, min, max)];
+}
+
+void Colormap::map(const double *values, int count, int stride, double min,
+                   double max, Color *colors) const {
+  const auto scale = (max != min ? 1. / (max - min) : 0.);
+  const auto n = size();
+  const auto &lut = *lut_;
+  std::array<int, 256> block{};
+  for (auto begin = 0; begin < count; begin += block.size()) {
+    auto end = std::min(count, begin + static_cast<int>(block.size()));
+    if (cyclic_) {
+      for (auto i = begin; i < end; i++) {
+        block[i - begin] = static_cast<int>(
+            position((values[i * stride] - min) * scale, n, true));
+      }
+    } else {
+      for (auto i = begin; i < end; i++) {
+        block[i - begin] = static_cast<int>(
+            position((values[i * stride] - min) * scale, n, false));
+      }
+    }
+    for (auto i = begin; i < end; i++) {
+      colors[i] = lut[block[i - begin]];
+    }
+  }
+}
+
+auto Colormap::cos() -> const Colormap & {
+  static const Colormap map = [] {
+    std::vector<Color> lut(4096);
+    for (auto i = 0; i < static_cast<int>(lut.size()); i++) {
+      lut[i] = Color::cos(i * 6. / static_cast<double>(lut.size()));
+    }
+    return Colormap(lut, true);
+  }();
+  return map;
+}
+
+auto Colormap::viridis() -> const Colormap & {
+  static const Colormap map(polynomial(viridis_coeffs, 256));
+  return map;
+}
+
+auto Colormap::magma() -> const Colormap & {
+  static const Colormap map(polynomial(magma_coeffs, 256));
+  return map;
+}
+
+auto Colormap::turbo() -> const Colormap & {
+  static const Colormap map(polynomial(turbo_coeffs, 256));
+  return map;
+}
+
+}  // namespace cvplot
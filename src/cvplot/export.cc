@@ -0,0 +1,154 @@
+#include "cvplot/export.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "internal.h"
+
+namespace cvplot {
+
+struct Exporter::Queue {
+  struct Render {
+    Figure figure;
+    std::string filename;
+    Size size;
+    Encoding encoding;
+    std::promise<bool> promise;
+  };
+
+  struct Write {
+    cv::Mat mat;
+    std::string filename;
+    Encoding encoding;
+    std::promise<bool> promise;
+  };
+
+  std::mutex mutex;
+  std::condition_variable render_ready;
+  std::condition_variable write_ready;
+  std::condition_variable write_space;
+  std::condition_variable idle;
+  std::deque<Render> renders;
+  std::deque<Write> writes;
+  std::vector<std::thread> threads;
+  size_t capacity{0};
+  size_t pending{0};
+  bool stop{false};
+
+  void done() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--pending == 0) {
+      idle.notify_all();
+    }
+  }
+
+  void render() {
+    for (;;) {
+      std::unique_lock<std::mutex> lock(mutex);
+      render_ready.wait(lock, [this] { return stop || !renders.empty(); });
+      if (renders.empty()) {
+        return;
+      }
+      Render job(std::move(renders.front()));
+      renders.pop_front();
+      lock.unlock();
+      cv::Mat mat(cv::Size(job.size.width, job.size.height), CV_8UC3);
+      try {
+        if (job.figure.drawFit(&mat) == 0) {
+          job.promise.set_value(false);
+          done();
+          continue;
+        }
+      } catch (...) {
+        job.promise.set_exception(std::current_exception());
+        done();
+        continue;
+      }
+      // bounded, so rendering can't run far ahead of the writers
+      lock.lock();
+      write_space.wait(lock, [this] { return writes.size() < capacity; });
+      writes.push_back({mat, std::move(job.filename), job.encoding,
+                        std::move(job.promise)});
+      write_ready.notify_one();
+    }
+  }
+
+  void write() {
+    for (;;) {
+      std::unique_lock<std::mutex> lock(mutex);
+      write_ready.wait(lock, [this] { return stop || !writes.empty(); });
+      if (writes.empty()) {
+        return;
+      }
+      Write job(std::move(writes.front()));
+      writes.pop_front();
+      write_space.notify_one();
+      lock.unlock();
+      auto result = false;
+#if CV_MAJOR_VERSION >= 3
+      std::vector<uchar> bytes;
+      if (encode(job.mat, job.encoding, bytes)) {
+        std::ofstream file(job.filename, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(bytes.data()),
+                   static_cast<std::streamsize>(bytes.size()));
+        result = file.good();
+      }
+#endif
+      job.promise.set_value(result);
+      done();
+    }
+  }
+};
+
+Exporter::Exporter(int renderers, int writers) : queue_(new Queue()) {
+  auto cores =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  renderers = (renderers > 0 ? renderers : cores);
+  writers = (writers > 0 ? writers : cores);
+  queue_->capacity = static_cast<size_t>(writers) * 2;
+  for (auto i = 0; i < renderers; i++) {
+    queue_->threads.emplace_back(&Queue::render, queue_.get());
+  }
+  for (auto i = 0; i < writers; i++) {
+    queue_->threads.emplace_back(&Queue::write, queue_.get());
+  }
+}
+
+Exporter::~Exporter() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(queue_->mutex);
+    queue_->stop = true;
+  }
+  queue_->render_ready.notify_all();
+  queue_->write_ready.notify_all();
+  for (auto &t : queue_->threads) {
+    t.join();
+  }
+}
+
+auto Exporter::add(const Figure &figure, const std::string &filename, Size size,
+                   const Encoding &encoding) -> std::future<bool> {
+  std::promise<bool> promise;
+  auto future = promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(queue_->mutex);
+    queue_->renders.push_back(
+        {figure, filename, size, encoding, std::move(promise)});
+    queue_->pending++;
+  }
+  queue_->render_ready.notify_one();
+  return future;
+}
+
+void Exporter::wait() {
+  std::unique_lock<std::mutex> lock(queue_->mutex);
+  queue_->idle.wait(lock, [this] { return queue_->pending == 0; });
+}
+
+}  // namespace cvplot
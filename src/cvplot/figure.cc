@@ -1,6 +1,12 @@
 #include "cvplot/figure.h"
 
+#include <array>
 #include <cmath>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <opencv2/imgproc/imgproc.hpp>
 #if CV_MAJOR_VERSION >= 3
 #include <opencv2/imgcodecs.hpp>
@@ -8,18 +14,93 @@
 
 #include "cvplot/window.h"
 #include "internal.h"
-
-#if CV_MAJOR_VERSION >= 3
-constexpr int LINE_AA = cv::LINE_AA;
-#else
-constexpr int LINE_AA = CV_AA;
-#endif
+#include "kernel.h"
 
 namespace cvplot {
 
 namespace {
+// Figures by name, sharded so threads working on different figures rarely
+// share a lock. Entries are never erased and unordered_map nodes don't
+// move, so returned references stay valid.
+struct Shard {
+  std::mutex mutex;
+  std::unordered_map<std::string, Figure> figures;
+};
+const size_t shard_count = 16;
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
-std::map<std::string, Figure> shared_figures_;
+Shard shared_figures_[shard_count];  // NOLINT(modernize-avoid-c-arrays)
+
+// Min and max over columns [first, first + columns) of `count` entries
+// stored back to back. The comparisons are selects, false for NaN, so NaNs
+// are skipped and the loops compile to packed min/max instructions.
+void boundsColumns(const double *data, size_t count, int stride, int first,
+                   int columns, double &min, double &max) {
+  for (auto c = first; c < first + columns; c++) {
+    const auto *column = data + c;
+    auto lo = min;
+    auto hi = max;
+    for (size_t i = 0; i < count; i++) {
+      auto v = column[i * stride];
+      lo = (v < lo ? v : lo);
+      hi = (v > hi ? v : hi);
+    }
+    min = lo;
+    max = hi;
+  }
+}
+
+// Entries per thread before bounds are split across threads.
+const size_t parallel_bounds = 1 << 20;
+
+// Columns [first, first + columns) and their running bounds.
+struct Span {
+  int first;
+  int columns;
+  double min;
+  double max;
+};
+using Spans = std::array<Span, 2>;
+
+void boundsSpans(const double *data, size_t count, int stride, Spans &spans) {
+  for (auto &s : spans) {
+    boundsColumns(data, count, stride, s.first, s.columns, s.min, s.max);
+  }
+}
+
+// boundsSpans, with large series split across threads. Each thread reduces
+// all spans of its chunk, so threads are started once per series.
+void boundsReduce(const double *data, size_t count, int stride, Spans &spans) {
+  size_t threads = 1;
+  if (count > parallel_bounds) {
+    threads = std::min(static_cast<size_t>(std::max(
+                           1U, std::thread::hardware_concurrency())),
+                       count / parallel_bounds + 1);
+  }
+  if (threads <= 1) {
+    boundsSpans(data, count, stride, spans);
+    return;
+  }
+  auto chunk = (count + threads - 1) / threads;
+  std::vector<Spans> partial(threads, spans);
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      auto begin = std::min(count, t * chunk);
+      boundsSpans(data + begin * stride, std::min(chunk, count - begin),
+                  stride, partial[t]);
+    });
+  }
+  boundsSpans(data, chunk, stride, partial[0]);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  for (const auto &p : partial) {
+    for (size_t s = 0; s < spans.size(); s++) {
+      spans[s].min = std::min(spans[s].min, p[s].min);
+      spans[s].max = std::max(spans[s].max, p[s].max);
+    }
+  }
+}
 }  // namespace
 
 void Series::verifyParams() const {
@@ -81,6 +162,40 @@ auto Series::clear() -> Series & {
   return *this;
 }
 
+auto Series::feed(size_t capacity) -> std::shared_ptr<Feed> {
+  return feeds_.add(capacity);
+}
+
+auto Series::drain() -> Series & {
+  Feed::Sample s;
+  for (const auto &feed : feeds_) {
+    while (feed->pop(s)) {
+      const auto *v = s.values;
+      switch (s.count + (s.keyed ? 3 : 0)) {
+        case 1:
+          addValue(v[0]);
+          break;
+        case 2:
+          addValue(v[0], v[1]);
+          break;
+        case 3:
+          addValue(v[0], v[1], v[2]);
+          break;
+        case 4:
+          add(s.key, v[0]);
+          break;
+        case 5:
+          add(s.key, Point2(v[0], v[1]));
+          break;
+        case 6:
+          add(s.key, Point3(v[0], v[1], v[2]));
+          break;
+      }
+    }
+  }
+  return *this;
+}
+
 auto Series::type(enum Type type) -> Series & {
   type_ = type;
   return *this;
@@ -91,105 +206,90 @@ auto Series::color(Color color) -> Series & {
   return *this;
 }
 
+auto Series::quality(enum Quality quality) -> Series & {
+  quality_ = quality;
+  return *this;
+}
+
 auto Series::dynamicColor(bool dynamic_color) -> Series & {
   dynamic_color_ = dynamic_color;
   return *this;
 }
 
+auto Series::colormap(const Colormap &colormap, double min, double max)
+    -> Series & {
+  colormap_ = colormap;
+  color_min_ = min;
+  color_max_ = max;
+  return *this;
+}
+
 auto Series::legend(bool legend) -> Series & {
   legend_ = legend;
   return *this;
 }
 
+auto Series::reserve(size_t count) -> Series & {
+  entries_.reserve(count);
+  data_.reserve(count * (dims_ + depth_ > 0 ? dims_ + depth_ : 2));
+  return *this;
+}
+
 auto Series::add(const std::vector<std::pair<double, double>> &data)
     -> Series & {
-  ensureDimsDepth(1, 1);
-  for (const auto &d : data) {
-    entries_.push_back(static_cast<int>(data_.size()));
-    data_.push_back(d.first);
-    data_.push_back(d.second);
-  }
-  return *this;
+  return addRange(data.begin(), data.end());
 }
 
 auto Series::add(const std::vector<std::pair<double, Point2>> &data)
     -> Series & {
-  ensureDimsDepth(1, 2);
-  for (const auto &d : data) {
-    entries_.push_back(static_cast<int>(data_.size()));
-    data_.push_back(d.first);
-    data_.push_back(d.second.x);
-    data_.push_back(d.second.y);
-  }
-  return *this;
+  return addRange(data.begin(), data.end());
 }
 
 auto Series::add(const std::vector<std::pair<double, Point3>> &data)
     -> Series & {
-  ensureDimsDepth(1, 3);
-  for (const auto &d : data) {
-    entries_.push_back(static_cast<int>(data_.size()));
-    data_.push_back(d.first);
-    data_.push_back(d.second.x);
-    data_.push_back(d.second.y);
-    data_.push_back(d.second.z);
-  }
-  return *this;
+  return addRange(data.begin(), data.end());
 }
 
 auto Series::addValue(const std::vector<double> &values) -> Series & {
-  std::vector<std::pair<double, double>> data(values.size());
-  auto i = 0;
-  for (auto &d : data) {
-    d.first = static_cast<double>(i + entries_.size());
-    d.second = values[i++];
-  }
-  return add(data);
+  return addValueRange(values.begin(), values.end());
 }
 
 auto Series::addValue(const std::vector<Point2> &values) -> Series & {
-  std::vector<std::pair<double, Point2>> data(values.size());
-  auto i = 0;
-  for (auto &d : data) {
-    d.first = static_cast<double>(i + entries_.size());
-    d.second = values[i++];
-  }
-  return add(data);
+  return addValueRange(values.begin(), values.end());
 }
 
 auto Series::addValue(const std::vector<Point3> &values) -> Series & {
-  std::vector<std::pair<double, Point3>> data(values.size());
-  auto i = 0;
-  for (auto &d : data) {
-    d.first = static_cast<double>(i + entries_.size());
-    d.second = values[i++];
-  }
-  return add(data);
+  return addValueRange(values.begin(), values.end());
 }
 
 auto Series::add(double key, double value) -> Series & {
-  return add(std::vector<std::pair<double, double>>({{key, value}}));
+  std::pair<double, double> data(key, value);
+  return addRange(&data, &data + 1);
 }
 
 auto Series::add(double key, Point2 value) -> Series & {
-  return add(std::vector<std::pair<double, Point2>>({{key, value}}));
+  std::pair<double, Point2> data(key, value);
+  return addRange(&data, &data + 1);
 }
 
 auto Series::add(double key, Point3 value) -> Series & {
-  return add(std::vector<std::pair<double, Point3>>({{key, value}}));
+  std::pair<double, Point3> data(key, value);
+  return addRange(&data, &data + 1);
 }
 
 auto Series::addValue(double value) -> Series & {
-  return addValue(std::vector<double>({value}));
+  return addValueRange(&value, &value + 1);
 }
 
 auto Series::addValue(double value_a, double value_b) -> Series & {
-  return addValue(std::vector<Point2>({{value_a, value_b}}));
+  Point2 value(value_a, value_b);
+  return addValueRange(&value, &value + 1);
 }
 
 auto Series::addValue(double value_a, double value_b, double value_c)
     -> Series & {
-  return addValue(std::vector<Point3>({{value_a, value_b, value_c}}));
+  Point3 value(value_a, value_b, value_c);
+  return addValueRange(&value, &value + 1);
 }
 
 auto Series::set(const std::vector<std::pair<double, double>> &data)
@@ -211,65 +311,90 @@ auto Series::set(const std::vector<std::pair<double, Point3>> &data)
 }
 
 auto Series::setValue(const std::vector<double> &values) -> Series & {
-  std::vector<std::pair<double, double>> data(values.size());
-  auto i = 0;
-  for (auto &d : data) {
-    d.first = i;
-    d.second = values[i++];
-  }
-  return set(data);
+  clear();
+  return addValue(values);
 }
 
 auto Series::setValue(const std::vector<Point2> &values) -> Series & {
-  std::vector<std::pair<double, Point2>> data(values.size());
-  auto i = 0;
-  for (auto &d : data) {
-    d.first = i;
-    d.second = values[i++];
-  }
-  return set(data);
+  clear();
+  return addValue(values);
 }
 
 auto Series::setValue(const std::vector<Point3> &values) -> Series & {
-  std::vector<std::pair<double, Point3>> data(values.size());
-  auto i = 0;
-  for (auto &d : data) {
-    d.first = i;
-    d.second = values[i++];
-  }
-  return set(data);
+  clear();
+  return addValue(values);
 }
 
 auto Series::set(double key, double value) -> Series & {
-  return set(std::vector<std::pair<double, double>>({{key, value}}));
+  clear();
+  return add(key, value);
 }
 
 auto Series::set(double key, double value_a, double value_b) -> Series & {
-  return set(
-      std::vector<std::pair<double, Point2>>({{key, {value_a, value_b}}}));
+  clear();
+  return add(key, Point2(value_a, value_b));
 }
 
 auto Series::set(double key, double value_a, double value_b, double value_c)
     -> Series & {
-  return set(std::vector<std::pair<double, Point3>>(
-      {{key, {value_a, value_b, value_c}}}));
+  clear();
+  return add(key, Point3(value_a, value_b, value_c));
 }
 
 auto Series::setValue(double value) -> Series & {
-  return setValue(std::vector<double>({value}));
+  clear();
+  return addValue(value);
 }
 
 auto Series::setValue(double value_a, double value_b) -> Series & {
-  return setValue(std::vector<Point2>({{value_a, value_b}}));
+  clear();
+  return addValue(value_a, value_b);
 }
 
 auto Series::setValue(double value_a, double value_b, double value_c)
     -> Series & {
-  return setValue(std::vector<Point3>({{value_a, value_b, value_c}}));
+  clear();
+  return addValue(value_a, value_b, value_c);
+}
+
+auto Series::set(const Bins &bins) -> Series & {
+  if (type_ != Histogram && type_ != Vistogram) {
+    type_ = Histogram;
+  }
+  clear();
+  ensureDimsDepth(1, 1);
+  entries_.reserve(bins.size());
+  data_.reserve(bins.size() * 2);
+  for (auto i = 0; i < bins.size(); i++) {
+    entries_.push_back(static_cast<int>(data_.size()));
+    data_.push_back(bins.center(i));
+    data_.push_back(static_cast<double>(bins.count(i)));
+  }
+  return *this;
+}
+
+auto Series::set(const Quantiles &quantiles, double lower, double upper)
+    -> Series & {
+  type_ = RangeLine;
+  clear();
+  ensureDimsDepth(1, 3);
+  const auto &buckets = quantiles.buckets();
+  entries_.reserve(buckets.size());
+  data_.reserve(buckets.size() * 4);
+  for (const auto &b : buckets) {
+    entries_.push_back(static_cast<int>(data_.size()));
+    data_.push_back((static_cast<double>(b.first) + .5) * quantiles.width());
+    data_.push_back(b.second.quantile(.5));
+    data_.push_back(b.second.quantile(lower));
+    data_.push_back(b.second.quantile(upper));
+  }
+  return *this;
 }
 
 auto Series::label() const -> const std::string & { return label_; }
 
+auto Series::size() const -> size_t { return entries_.size(); }
+
 auto Series::legend() const -> bool { return legend_; }
 
 auto Series::color() const -> Color { return color_; }
@@ -285,43 +410,23 @@ auto Series::flipAxis() const -> bool {
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Series::bounds(double &x_min, double &x_max, double &y_min, double &y_max,
                     int &n_max, int &p_max) const {
-  for (const auto &e : entries_) {
-    auto xe = e;
-    auto xd = dims_;
-    auto ye = e + dims_;
-    auto yd = depth_ - (dynamic_color_ ? 1 : 0);
-    if (type_ == Circle) {
-      yd = 1;
-    }
+  if (!entries_.empty()) {
+    auto values = (type_ == Circle ? 1 : depth_ - (dynamic_color_ ? 1 : 0));
+    auto x_column = 0;
+    auto x_count = dims_;
+    auto y_column = dims_;
+    auto y_count = values;
     if (flipAxis()) {
-      auto s = xe;
-      xe = ye;
-      ye = s;
-      s = xd;
-      xd = yd;
-      yd = s;
+      x_column = dims_;
+      x_count = values;
+      y_column = 0;
+      y_count = dims_;
     }
     if (type_ != Horizontal) {  // TODO(leo): check Horizontal/Vertical logic
-      EXPECT_EQ(xd, 1);
-      const auto &x = data_[xe];
-      if (x_min > x) {
-        x_min = x;
-      }
-      if (x_max < x) {
-        x_max = x;
-      }
-    }
-    if (type_ != Vertical) {
-      for (auto yi = ye, _y = yi + yd; yi != _y; yi++) {
-        const auto &y = data_[yi];
-        if (y_min > y) {
-          y_min = y;
-        }
-        if (y_max < y) {
-          y_max = y;
-        }
-      }
+      EXPECT_EQ(x_count, 1);
     }
+    columnBounds(x_column, (type_ != Horizontal ? 1 : 0), x_min, x_max,
+                 y_column, (type_ != Vertical ? y_count : 0), y_min, y_max);
   }
   if (n_max < entries_.size()) {
     n_max = static_cast<int>(entries_.size());
@@ -331,213 +436,104 @@ void Series::bounds(double &x_min, double &x_max, double &y_min, double &y_max,
   }
 }
 
+void Series::columnBounds(int x_first, int x_count, double &x_min,
+                          double &x_max, int y_first, int y_count,
+                          double &y_min, double &y_max) const {
+  auto stride = dims_ + depth_;
+  Spans spans = {{{x_first, x_count, x_min, x_max},
+                  {y_first, y_count, y_min, y_max}}};
+  if (data_.size() == entries_.size() * stride) {
+    boundsReduce(data_.data(), entries_.size(), stride, spans);
+  } else {
+    for (const auto &e : entries_) {
+      boundsSpans(&data_[e], 1, stride, spans);
+    }
+  }
+  x_min = spans[0].min, x_max = spans[0].max;
+  y_min = spans[1].min, y_max = spans[1].max;
+}
+
+void Series::dynamicColors(std::vector<Color> &colors) const {
+  colors.resize(entries_.size());
+  if (entries_.empty()) {
+    return;
+  }
+  auto stride = dims_ + depth_;
+  auto column = stride - 1;
+  if (data_.size() == entries_.size() * stride) {
+    colormap_.map(&data_[entries_[0] + column],
+                  static_cast<int>(entries_.size()), stride, color_min_,
+                  color_max_, colors.data());
+  } else {
+    for (size_t i = 0; i < entries_.size(); i++) {
+      colors[i] =
+          colormap_.color(data_[entries_[i] + column], color_min_, color_max_);
+    }
+  }
+}
+
 void Series::dot(void *b, int x, int y, int r) const {
   Trans trans(b);
   cv::circle(trans.with(color_), {x, y}, r, color2scalar(color_), -1, LINE_AA);
 }
 
-// NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Series::draw(void *buffer, double x_min, double x_max, double y_min,
                   double y_max, double xs, double xd, double ys, double yd,
                   double x_axis, double y_axis, int unit, double offset) const {
   if (dims_ == 0 || depth_ == 0) {
     return;
   }
-  Trans trans(*static_cast<cv::Mat *>(buffer));
-  auto color = color2scalar(color_);
+  auto &b = *static_cast<cv::Mat *>(buffer);
+  Scale scale{x_min, x_max, y_min,  y_max,  xs,   xd,
+              ys,    yd,    x_axis, y_axis, unit, offset};
   switch (type_) {
     case Line:
+      drawKernel<Line>(*this, dynamic_color_, quality_, b, scale);
+      break;
     case DotLine:
+      drawKernel<DotLine>(*this, dynamic_color_, quality_, b, scale);
+      break;
     case Dots:
+      drawKernel<Dots>(*this, dynamic_color_, quality_, b, scale);
+      break;
     case FillLine:
-    case RangeLine: {
-      if (type_ == FillLine) {
-        bool has_last = false;
-        double last_x = NAN;
-        double last_y = NAN;
-        for (const auto &e : entries_) {
-          auto x = data_[e];
-          auto y = data_[e + dims_];
-          if (dynamic_color_) {
-            color = color2scalar(Color::cos(data_[e + dims_ + 1]));
-          }
-          cv::Point point(static_cast<int>(x * xs + xd),
-                          static_cast<int>(y * ys + yd));
-          if (has_last) {
-            // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
-            cv::Point points[4] = {
-                point,
-                {point.x, static_cast<int>(y_axis * ys + yd)},
-                {static_cast<int>(last_x * xs + xd),
-                 static_cast<int>(y_axis * ys + yd)},
-                {static_cast<int>(last_x * xs + xd),
-                 static_cast<int>(last_y * ys + yd)},
-            };
-            cv::fillConvexPoly(trans.with(color_.a / 2),
-                               static_cast<cv::Point *>(points), 4, color,
-                               LINE_AA);
-          } else {
-            has_last = true;
-          }
-          last_x = x, last_y = y;
-        }
-      } else if (type_ == RangeLine) {
-        bool has_last = false;
-        double last_x = NAN;
-        double last_y1 = NAN;
-        double last_y2 = NAN;
-        for (const auto &e : entries_) {
-          auto x = data_[e];
-          auto y1 = data_[e + dims_ + 1];
-          auto y2 = data_[e + dims_ + 2];
-          if (dynamic_color_) {
-            color = color2scalar(Color::cos(data_[e + dims_ + 1]));
-          }
-          if (has_last) {
-            // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
-            cv::Point points[4] = {
-                {static_cast<int>(x * xs + xd), static_cast<int>(y1 * ys + yd)},
-                {static_cast<int>(x * xs + xd), static_cast<int>(y2 * ys + yd)},
-                {static_cast<int>(last_x * xs + xd),
-                 static_cast<int>(last_y2 * ys + yd)},
-                {static_cast<int>(last_x * xs + xd),
-                 static_cast<int>(last_y1 * ys + yd)},
-            };
-            cv::fillConvexPoly(trans.with(color_.a / 2),
-                               static_cast<cv::Point *>(points), 4, color,
-                               LINE_AA);
-          } else {
-            has_last = true;
-          }
-          last_x = x, last_y1 = y1, last_y2 = y2;
-        }
-      }
-      bool has_last = false;
-      double last_x = NAN;
-      double last_y = NAN;
-      for (const auto &e : entries_) {
-        auto x = data_[e];
-        auto y = data_[e + dims_];
-        if (dynamic_color_) {
-          color = color2scalar(Color::cos(data_[e + dims_ + 1]));
-        }
-        cv::Point point(static_cast<int>(x * xs + xd),
-                        static_cast<int>(y * ys + yd));
-        if (has_last) {
-          if (type_ == DotLine || type_ == Line || type_ == FillLine ||
-              type_ == RangeLine) {
-            cv::line(trans.with(color_),
-                     {static_cast<int>(last_x * xs + xd),
-                      static_cast<int>(last_y * ys + yd)},
-                     point, color, 1, LINE_AA);
-          }
-        } else {
-          has_last = true;
-        }
-        if (type_ == DotLine || type_ == Dots) {
-          cv::circle(trans.with(color_), point, 2, color, 1, LINE_AA);
-        }
-        last_x = x, last_y = y;
-      }
-    } break;
+      drawKernel<FillLine>(*this, dynamic_color_, quality_, b, scale);
+      break;
+    case RangeLine:
+      drawKernel<RangeLine>(*this, dynamic_color_, quality_, b, scale);
+      break;
+    case Histogram:
+      drawKernel<Histogram>(*this, dynamic_color_, quality_, b, scale);
+      break;
     case Vistogram:
-    case Histogram: {
-      auto u = 2 * unit;
-      auto o = static_cast<int>(2 * u * offset);
-      for (const auto &e : entries_) {
-        auto x = data_[e];
-        auto y = data_[e + dims_];
-        if (dynamic_color_) {
-          color = color2scalar(Color::cos(data_[e + dims_ + 1]));
-        }
-        if (type_ == Histogram) {
-          cv::rectangle(trans.with(color_),
-                        {static_cast<int>(x * xs + xd) - u + o,
-                         static_cast<int>(y_axis * ys + yd)},
-                        {static_cast<int>(x * xs + xd) + u + o,
-                         static_cast<int>(y * ys + yd)},
-                        color, -1, LINE_AA);
-        } else if (type_ == Vistogram) {
-          cv::rectangle(trans.with(color_),
-                        {static_cast<int>(x_axis * xs + xd),
-                         static_cast<int>(x * ys + yd) - u + o},
-                        {static_cast<int>(y * xs + xd),
-                         static_cast<int>(x * ys + yd) + u + o},
-                        color, -1, LINE_AA);
-        }
-      }
-
-    } break;
+      drawKernel<Vistogram>(*this, dynamic_color_, quality_, b, scale);
+      break;
     case Horizontal:
-    case Vertical: {
-      for (const auto &e : entries_) {
-        auto y = data_[e + dims_];
-        if (dynamic_color_) {
-          color = color2scalar(Color::cos(data_[e + dims_ + 1]));
-        }
-        if (type_ == Horizontal) {
-          cv::line(trans.with(color_),
-                   {static_cast<int>(x_min * xs + xd),
-                    static_cast<int>(y * ys + yd)},
-                   {static_cast<int>(x_max * xs + xd),
-                    static_cast<int>(y * ys + yd)},
-                   color, 1, LINE_AA);
-        } else if (type_ == Vertical) {
-          cv::line(trans.with(color_),
-                   {static_cast<int>(y * xs + xd),
-                    static_cast<int>(y_min * ys + yd)},
-                   {static_cast<int>(y * xs + xd),
-                    static_cast<int>(y_max * ys + yd)},
-                   color, 1, LINE_AA);
-        }
-      }
-    } break;
-    case Range: {
-      bool has_last = false;
-      cv::Point last_a;
-      cv::Point last_b;
-      for (const auto &e : entries_) {
-        auto x = data_[e];
-        auto y_a = data_[e + dims_];
-        auto y_b = data_[e + dims_ + 1];
-        if (dynamic_color_) {
-          color = color2scalar(Color::cos(data_[e + dims_ + 2]));
-        }
-        cv::Point point_a(static_cast<int>(x * xs + xd),
-                          static_cast<int>(y_a * ys + yd));
-        cv::Point point_b(static_cast<int>(x * xs + xd),
-                          static_cast<int>(y_b * ys + yd));
-        if (has_last) {
-          // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
-          cv::Point points[4] = {point_a, point_b, last_b, last_a};
-          cv::fillConvexPoly(trans.with(color_),
-                             static_cast<cv::Point *>(points), 4, color,
-                             LINE_AA);
-        } else {
-          has_last = true;
-        }
-        last_a = point_a, last_b = point_b;
-      }
-    } break;
-    case Circle: {
-      for (const auto &e : entries_) {
-        auto x = data_[e];
-        auto y = data_[e + dims_];
-        auto r = data_[e + dims_ + 1];
-        if (dynamic_color_) {
-          color = color2scalar(Color::cos(data_[e + dims_ + 2]));
-        }
-        cv::Point point(static_cast<int>(x * xs + xd),
-                        static_cast<int>(y * ys + yd));
-        cv::circle(trans.with(color_), point, static_cast<int>(r), color, -1,
-                   LINE_AA);
-      }
-    } break;
+      drawKernel<Horizontal>(*this, dynamic_color_, quality_, b, scale);
+      break;
+    case Vertical:
+      drawKernel<Vertical>(*this, dynamic_color_, quality_, b, scale);
+      break;
+    case Range:
+      drawKernel<Range>(*this, dynamic_color_, quality_, b, scale);
+      break;
+    case Circle:
+      drawKernel<Circle>(*this, dynamic_color_, quality_, b, scale);
+      break;
+  }
+}
+
+auto Figure::drain() -> Figure & {
+  for (auto &s : series_) {
+    s.drain();
   }
+  return *this;
 }
 
 auto Figure::clear() -> Figure & {
   series_.clear();
+  index_.clear();
+  generation_.next();
   return *this;
 }
 
@@ -589,6 +585,11 @@ auto Figure::textColor(Color color) -> Figure & {
   return *this;
 }
 
+auto Figure::hud(bool hud) -> Figure & {
+  hud_ = hud;
+  return *this;
+}
+
 auto Figure::backgroundColor() -> Color { return background_color_; }
 
 auto Figure::axisColor() -> Color { return axis_color_; }
@@ -598,20 +599,26 @@ auto Figure::subaxisColor() -> Color { return sub_axis_color_; }
 auto Figure::textColor() -> Color { return text_color_; }
 
 auto Figure::series(const std::string &label) -> Series & {
-  for (auto &s : series_) {
-    if (s.label() == label) {
-      return s;
-    }
+  auto it = index_.find(label);
+  if (it != index_.end()) {
+    return series_[it->second];
   }
-  Series s(label, Line, Color::hash(label));
-  series_.push_back(s);
+  index_.emplace(label, series_.size());
+  series_.emplace_back(label, Line, Color::hash(label));
   return series_.back();
 }
 
+auto Figure::handle(const std::string &label) -> SeriesHandle {
+  return SeriesHandle(series(label), generation_.counter());
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void Figure::draw(void *b, double x_min, double x_max, double y_min,
                   double y_max, int n_max, int p_max) const {
   auto &buffer = *static_cast<cv::Mat *>(b);
+  Timer total;
+  Timer stage;
+  auto composed = Trans::composed();
   Trans trans(b);
 
   // draw background and sub axis square
@@ -733,6 +740,8 @@ void Figure::draw(void *b, double x_min, double x_max, double y_min,
            {static_cast<int>(x_axis * xs + xd), buffer.rows - border_size_},
            color2scalar(axis_color_), 1, LINE_AA);
 
+  stage.lap(stats_.grid);
+
   // draw plot
   auto index = 0;
   for (const auto &s : series_) {
@@ -750,6 +759,8 @@ void Figure::draw(void *b, double x_min, double x_max, double y_min,
             static_cast<double>(index) / static_cast<double>(series_.size()));
   }
 
+  stage.lap(stats_.series);
+
   // draw label names
   index = 0;
   for (const auto &s : series_) {
@@ -776,6 +787,32 @@ void Figure::draw(void *b, double x_min, double x_max, double y_min,
           3);
     index++;
   }
+  stage.lap(stats_.legend);
+
+  // draw timings, of this draw so far and of the one before
+  if (hud_) {
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
+    const std::pair<const char *, const Timing *> stages[] = {
+        {"bounds", &stats_.bounds}, {"grid", &stats_.grid},
+        {"series", &stats_.series}, {"legend", &stats_.legend},
+        {"compose", &stats_.compose}, {"draw", &stats_.draw},
+    };
+    index = 0;
+    for (const auto &s : stages) {
+      std::ostringstream out;
+      out << std::fixed << std::setprecision(2) << s.first << " "
+          << s.second->last * 1e3 << " ms, avg " << s.second->average * 1e3
+          << ", max " << s.second->max * 1e3;
+      cv::putText(trans.with(text_color_), out.str(),
+                  {border_size_ + 5, border_size_ + 12 * index + 12},
+                  cv::FONT_HERSHEY_SIMPLEX, 0.3, color2scalar(text_color_), 1.);
+      index++;
+    }
+  }
+
+  trans.flush();
+  stats_.compose.add(Trans::composed() - composed);
+  total.lap(stats_.draw);
 }
 
 auto Figure::drawFit(void *buffer) const -> int {
@@ -787,10 +824,12 @@ auto Figure::drawFit(void *buffer) const -> int {
   auto p_max = grid_padding_;
 
   // find value bounds
+  Timer timer;
   for (const auto &s : series_) {
     s.verifyParams();
     s.bounds(x_min, x_max, y_min, y_max, n_max, p_max);
   }
+  timer.lap(stats_.bounds);
 
   if (n_max != 0) {
     draw(buffer, x_min, x_max, y_min, y_max, n_max, p_max);
@@ -813,6 +852,41 @@ auto Figure::drawFile(const std::string &filename, Size size) const -> bool {
   return false;
 }
 
+auto Figure::drawFile(const std::string &filename, Size size,
+                      const Encoding &encoding) const -> bool {
+#if CV_MAJOR_VERSION >= 3
+  cv::Mat mat(cv::Size(size.width, size.height), CV_8UC3);
+  int n_max = drawFit(&mat);
+  std::vector<uchar> bytes;
+  if (n_max != 0 && encode(mat, encoding, bytes)) {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+  }
+#endif
+  return false;
+}
+
+auto Figure::drawBytes(std::vector<uint8_t> &bytes, Size size,
+                       const Encoding &encoding) const -> bool {
+#if CV_MAJOR_VERSION >= 3
+  cv::Mat mat(cv::Size(size.width, size.height), CV_8UC3);
+  int n_max = drawFit(&mat);
+  if (n_max != 0) {
+    return encode(mat, encoding, bytes);
+  }
+#endif
+  return false;
+}
+
+auto Figure::drawRaw(uint8_t *bgr, Size size, int stride) const -> bool {
+  cv::Mat mat(cv::Size(size.width, size.height), CV_8UC3, bgr,
+              (stride > 0 ? static_cast<size_t>(stride)
+                          : static_cast<size_t>(cv::Mat::AUTO_STEP)));
+  return drawFit(&mat) != 0;
+}
+
 void Figure::show(bool flush) const {
   Rect rect(0, 0, 0, 0);
   auto &buffer = *static_cast<cv::Mat *>(view_.buffer(rect));
@@ -827,12 +901,15 @@ void Figure::show(bool flush) const {
 }
 
 auto figure(const std::string &name) -> Figure & {
-  if (shared_figures_.count(name) == 0) {
+  auto &shard = shared_figures_[std::hash<std::string>()(name) % shard_count];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.figures.find(name);
+  if (it == shard.figures.end()) {
+    // Window::view takes the window's own lock, shared by all shards
     auto &view = Window::current().view(name);
-    shared_figures_.insert(
-        std::map<std::string, Figure>::value_type(name, Figure(view)));
+    it = shard.figures.emplace(name, Figure(view)).first;
   }
-  return shared_figures_.at(name);
+  return it->second;
 }
 
 }  // namespace cvplot
@@ -1,9 +1,18 @@
 #ifndef CVPLOT_INTERNAL_H
 #define CVPLOT_INTERNAL_H
 
+#include <atomic>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <opencv2/core/core.hpp>
+#include <string>
+#include <vector>
+#if CV_MAJOR_VERSION >= 3
+#include <opencv2/imgcodecs.hpp>
+#endif
+
+#include "cvplot/window.h"
 
 #define EXPECT_EQ(a__, b__)                                                    \
   do {                                                                         \
@@ -25,38 +34,143 @@ static auto value2snap(double value) -> double {
                    pow(10, floor(log10(value / 5))) * 5});
 }
 
+#if CV_MAJOR_VERSION >= 3
+static auto encode(const cv::Mat &mat, const Encoding &encoding,
+                   std::vector<uchar> &bytes) -> bool {
+  std::vector<int> params;
+  std::string ext;
+  switch (encoding.format) {
+    case Encoding::Png:
+      ext = ".png";
+      params = {cv::IMWRITE_PNG_COMPRESSION, encoding.level};
+      break;
+    case Encoding::Jpeg:
+      ext = ".jpg";
+      params = {cv::IMWRITE_JPEG_QUALITY, encoding.level};
+      break;
+    case Encoding::Ppm:
+      ext = ".ppm";
+      params = {cv::IMWRITE_PXM_BINARY, 1};
+      break;
+    case Encoding::Bmp:
+      ext = ".bmp";
+      break;
+  }
+  return cv::imencode(ext, mat, bytes, params);
+}
+#endif
+
+// Scratch Mats for interim drawing steps. Storage is kept and handed out
+// again, so steady-state frames don't allocate. One pool per thread, as
+// figures also draw on exporter and UI threads.
+class Pool {
+ public:
+  auto acquire(cv::Size size, int type = CV_8UC3) -> cv::Mat {
+    auto bytes = size.width * size.height * CV_ELEM_SIZE(type);
+    if (bytes <= 0) {
+      return cv::Mat();
+    }
+    auto best = blocks_.size();
+    auto spare = blocks_.size();
+    for (size_t i = 0; i < blocks_.size(); i++) {
+      if (used_[i]) {
+        continue;
+      }
+      spare = i;
+      if (blocks_[i].cols >= bytes &&
+          (best == blocks_.size() || blocks_[i].cols < blocks_[best].cols)) {
+        best = i;
+      }
+    }
+    if (best == blocks_.size()) {
+      allocations_++;
+      if (spare == blocks_.size()) {
+        blocks_.emplace_back();
+        used_.push_back(false);
+      }
+      best = spare;
+      blocks_[best] = cv::Mat(1, bytes, CV_8U);
+    }
+    used_[best] = true;
+    // a header of the requested type, so writes into it never reallocate
+    return cv::Mat(size, type, blocks_[best].data);
+  }
+
+  void release(const cv::Mat &mat) {
+    for (size_t i = 0; i < blocks_.size(); i++) {
+      if (blocks_[i].data == mat.datastart) {
+        used_[i] = false;
+      }
+    }
+  }
+
+  static auto local() -> Pool &;
+  static auto allocations() -> size_t { return allocations_; }
+
+ protected:
+  std::vector<cv::Mat> blocks_;
+  std::vector<bool> used_;
+  static std::atomic<size_t> allocations_;
+};
+
+// Adds the time of each stage to its timing, a stage ending where the next
+// begins.
+class Timer {
+ public:
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+
+  void lap(Timing &timing) {
+    auto now = std::chrono::steady_clock::now();
+    timing.add(std::chrono::duration<double>(now - start_).count());
+    start_ = now;
+  }
+
+ protected:
+  std::chrono::steady_clock::time_point start_;
+};
+
 class Trans {
  public:
   Trans(void *buffer) : Trans(*(cv::Mat *)buffer) {}
 
-  Trans(cv::Mat &buffer) : original_(buffer), alpha_(0), interim_(nullptr) {}
+  Trans(cv::Mat &buffer) : original_(buffer), alpha_(0), interim_(false) {}
 
   Trans(cv::Mat &buffer, int alpha) : Trans(buffer) { setup(alpha); }
 
   ~Trans() { flush(); }
 
-  auto get() const -> cv::Mat & {
-    return (interim_ != nullptr ? *interim_ : original_);
-  }
+  auto get() -> cv::Mat & { return (interim_ ? scratch_ : original_); }
 
   void setup(int alpha) {
     bool transparent = (alpha != 255);
     if (transparent) {
-      interim_ = new cv::Mat();
-      original_.copyTo(*interim_);
+      auto start = std::chrono::steady_clock::now();
+      scratch_ = Pool::local().acquire(original_.size(), original_.type());
+      original_.copyTo(scratch_);
+      interim_ = true;
+      total() += std::chrono::steady_clock::now() - start;
     }
     alpha_ = alpha;
   }
 
   void flush() {
     if (interim_) {
+      auto start = std::chrono::steady_clock::now();
       auto weight = alpha_ / 255.;
-      cv::addWeighted(*interim_, weight, original_, 1 - weight, 0, original_);
-      delete interim_;
-      interim_ = nullptr;
+      cv::addWeighted(scratch_, weight, original_, 1 - weight, 0, original_);
+      Pool::local().release(scratch_);
+      scratch_ = cv::Mat();
+      interim_ = false;
+      total() += std::chrono::steady_clock::now() - start;
     }
   }
 
+  // seconds this thread spent copying and blending transparent layers, over
+  // all Trans, so nested draws are included in the difference across a stage
+  static auto composed() -> double {
+    return std::chrono::duration<double>(total()).count();
+  }
+
   auto with(int alpha) -> cv::Mat & {
     if (alpha != alpha_) {
       flush();
@@ -70,7 +184,13 @@ class Trans {
  protected:
   int alpha_;
   cv::Mat &original_;
-  cv::Mat *interim_;
+  cv::Mat scratch_;
+  bool interim_;
+
+  static auto total() -> std::chrono::steady_clock::duration & {
+    thread_local std::chrono::steady_clock::duration total{0};
+    return total;
+  }
 };
 
 }  // namespace cvplot
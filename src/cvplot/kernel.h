@@ -0,0 +1,421 @@
+#ifndef CVPLOT_KERNEL_H
+#define CVPLOT_KERNEL_H
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <vector>
+
+#include "cvplot/figure.h"
+#include "internal.h"
+
+#if CV_MAJOR_VERSION >= 3
+constexpr int LINE_AA = cv::LINE_AA;
+#else
+constexpr int LINE_AA = CV_AA;
+#endif
+
+namespace cvplot {
+
+// Data bounds and the mapping from data to pixels for one figure draw.
+struct Scale {
+  double x_min, x_max, y_min, y_max;
+  double xs, xd, ys, yd;
+  double x_axis, y_axis;
+  int unit;
+  double offset;
+
+  auto x(double v) const -> int { return static_cast<int>(v * xs + xd); }
+  auto y(double v) const -> int { return static_cast<int>(v * ys + yd); }
+};
+
+// Entries stored back to back, the usual layout.
+template <int Stride>
+struct Packed {
+  const double *data;
+  auto operator[](size_t i) const -> const double * {
+    return data + i * Stride;
+  }
+};
+
+// Entries at arbitrary offsets, after mixed layouts.
+struct Indexed {
+  const double *data;
+  const int *entries;
+  auto operator[](size_t i) const -> const double * {
+    return data + entries[i];
+  }
+};
+
+constexpr int LINE_8 = 8;
+
+// Scratch point arrays for projected series, kept per thread.
+static auto projected(int index) -> std::vector<cv::Point> & {
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
+  thread_local std::vector<cv::Point> points[4];
+  return points[index];
+}
+
+// Whether x never turns back along the points, so the area under them is a
+// simple polygon and fillPoly's even-odd rule leaves no holes.
+static auto monotonic(const std::vector<cv::Point> &points) -> bool {
+  auto rising = false;
+  auto falling = false;
+  for (size_t i = 1; i < points.size(); i++) {
+    rising = rising || points[i].x > points[i - 1].x;
+    falling = falling || points[i].x < points[i - 1].x;
+  }
+  return !(rising && falling);
+}
+
+// Fills the area between two point runs as a single polygon, `upper` in
+// order and `lower` back, so shared edges are not blended twice. Both runs
+// must be monotonic in x, see monotonic().
+static void fillBetween(cv::Mat &canvas, const std::vector<cv::Point> &upper,
+                        const std::vector<cv::Point> &lower,
+                        const cv::Scalar &color, int line) {
+  auto &outline = projected(3);
+  outline.assign(upper.begin(), upper.end());
+  outline.insert(outline.end(), lower.rbegin(), lower.rend());
+  const auto *points = outline.data();
+  auto count = static_cast<int>(outline.size());
+  cv::fillPoly(canvas, &points, &count, 1, color, line);
+}
+
+// Largest radius drawn from a cached sprite, larger circles are drawn
+// directly.
+const int max_sprite_radius = 64;
+
+// Coverage mask of a disc, or a ring of width 1, rendered once per radius
+// and line type.
+static auto sprite(int radius, bool filled, int line) -> const cv::Mat & {
+  thread_local std::vector<cv::Mat> cache;
+  auto index = static_cast<size_t>(radius * 4 + (filled ? 2 : 0) +
+                                   (line == LINE_AA ? 1 : 0));
+  if (cache.size() <= index) {
+    cache.resize(index + 1);
+  }
+  auto &mask = cache[index];
+  if (mask.empty()) {
+    auto size = 2 * radius + 5;
+    mask = cv::Mat(size, size, CV_8UC1, cv::Scalar(0));
+    cv::circle(mask, {radius + 2, radius + 2}, radius, cv::Scalar(255),
+               (filled ? -1 : 1), line);
+  }
+  return mask;
+}
+
+// Blends `color` into a BGR canvas by the coverage of `mask`, centered on
+// `center` and clipped to the canvas. The inner loop is plain integer
+// arithmetic, left for the compiler to vectorize. Only for CV_8UC3
+// canvases, other types are drawn with cv::circle.
+static void stamp(cv::Mat &canvas, const cv::Mat &mask, cv::Point center,
+                  const cv::Scalar &color) {
+  auto half = mask.rows / 2;
+  auto x0 = center.x - half;
+  auto y0 = center.y - half;
+  auto left = std::max(0, -x0);
+  auto top = std::max(0, -y0);
+  auto right = std::min(mask.cols, canvas.cols - x0);
+  auto bottom = std::min(mask.rows, canvas.rows - y0);
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
+  const int bgr[3] = {static_cast<int>(color[0]), static_cast<int>(color[1]),
+                      static_cast<int>(color[2])};
+  auto width = right - left;
+  for (auto y = top; y < bottom; y++) {
+    const auto *m = mask.ptr<uchar>(y) + left;
+    auto *d = canvas.ptr<uchar>(y0 + y) + (x0 + left) * 3;
+    for (auto x = 0; x < width; x++) {
+      auto a = static_cast<int>(m[x]);
+      for (auto c = 0; c < 3; c++) {
+        // exact division by 255 of a value up to 255 * 255
+        auto v = d[x * 3 + c] * (255 - a) + bgr[c] * a + 128;
+        d[x * 3 + c] = static_cast<uchar>((v + (v >> 8)) >> 8);
+      }
+    }
+  }
+}
+
+// Fills the box between two corners, both included, clipped to the canvas.
+// Bars are axis-aligned, so there is nothing to anti-alias: the first row
+// is written once and the others are copied from it.
+static void fillBox(cv::Mat &canvas, cv::Point a, cv::Point b,
+                    const cv::Scalar &color) {
+  auto left = std::max(0, std::min(a.x, b.x));
+  auto right = std::min(canvas.cols - 1, std::max(a.x, b.x));
+  auto top = std::max(0, std::min(a.y, b.y));
+  auto bottom = std::min(canvas.rows - 1, std::max(a.y, b.y));
+  if (left > right || top > bottom) {
+    return;
+  }
+  auto width = right - left + 1;
+  auto bytes = canvas.elemSize();
+  auto *first = canvas.ptr<uchar>(top) + left * bytes;
+  if (canvas.type() == CV_8UC3) {
+    for (auto x = 0; x < width; x++) {
+      for (auto c = 0; c < 3; c++) {
+        first[x * 3 + c] = static_cast<uchar>(color[c]);
+      }
+    }
+  } else {
+    canvas(cv::Rect(left, top, width, 1)).setTo(color);
+  }
+  for (auto y = top + 1; y <= bottom; y++) {
+    std::memcpy(canvas.ptr<uchar>(y) + left * bytes, first, width * bytes);
+  }
+}
+
+// Union of same-colored bars, as the extent of paint across each pixel
+// line along the bars, columns for a Histogram and rows for a Vistogram.
+// Dense bars overlap many times; this draws each pixel once.
+class Bars {
+ public:
+  void reset(int lines) {
+    low_.assign(static_cast<size_t>(lines), INT_MAX);
+    high_.assign(static_cast<size_t>(lines), INT_MIN);
+  }
+
+  // a bar across lines `from` to `to`, reaching from `a` to `b`
+  void add(int from, int to, int a, int b) {
+    from = std::max(0, from);
+    to = std::min(static_cast<int>(low_.size()) - 1, to);
+    auto lo = std::min(a, b);
+    auto hi = std::max(a, b);
+    for (auto i = from; i <= to; i++) {
+      low_[i] = std::min(low_[i], lo);
+      high_[i] = std::max(high_[i], hi);
+    }
+  }
+
+  // fills runs of lines with equal extents as single boxes
+  void fill(cv::Mat &canvas, bool columns, const cv::Scalar &color) const {
+    auto lines = static_cast<int>(low_.size());
+    for (auto i = 0; i < lines;) {
+      auto j = i + 1;
+      while (j < lines && low_[j] == low_[i] && high_[j] == high_[i]) {
+        j++;
+      }
+      if (low_[i] <= high_[i]) {
+        if (columns) {
+          fillBox(canvas, {i, low_[i]}, {j - 1, high_[i]}, color);
+        } else {
+          fillBox(canvas, {low_[i], i}, {high_[i], j - 1}, color);
+        }
+      }
+      i = j;
+    }
+  }
+
+ protected:
+  std::vector<int> low_;
+  std::vector<int> high_;
+};
+
+// Draws a series of type T. Everything that used to be tested per point,
+// type, dynamic color and line quality, is a template constant here. Data
+// is first projected to pixels in one tight pass, then each drawing loop
+// only walks the projected points.
+template <enum Type T, bool Dynamic, enum Quality Q>
+struct Kernel {
+  static const int stride = 1 + TypeDepth<T>::value + (Dynamic ? 1 : 0);
+  static const int line = (Q == Fast ? LINE_8 : LINE_AA);
+
+  static void draw(const Series &series, cv::Mat &buffer, const Scale &scale) {
+    thread_local std::vector<Color> colors;
+    if (Dynamic) {
+      series.dynamicColors(colors);
+    }
+    const auto &data = series.data_;
+    const auto &entries = series.entries_;
+    Trans trans(buffer);
+    if (data.size() == entries.size() * stride) {
+      run(Packed<stride>{data.data()}, entries.size(), colors.data(),
+          series.color_, trans, scale);
+    } else {
+      run(Indexed{data.data(), entries.data()}, entries.size(), colors.data(),
+          series.color_, trans, scale);
+    }
+  }
+
+  template <typename Rows>
+  static void project(const Rows &rows, size_t count, int column,
+                      const Scale &sc, std::vector<cv::Point> &points) {
+    points.resize(count);
+    auto *p = points.data();
+    for (size_t i = 0; i < count; i++) {
+      const auto *r = rows[i];
+      p[i].x = static_cast<int>(r[0] * sc.xs + sc.xd);
+      p[i].y = static_cast<int>(r[column] * sc.ys + sc.yd);
+    }
+  }
+
+  template <typename Rows>
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  static void run(const Rows &rows, size_t count, const Color *colors,
+                  const Color &base, Trans &trans, const Scale &sc) {
+    if (count == 0) {
+      return;
+    }
+    auto color = color2scalar(base);
+    auto at = [&](size_t i) -> cv::Scalar {
+      return (Dynamic ? color2scalar(colors[i]) : color);
+    };
+    auto &p = projected(0);
+    if (T != Vistogram && T != Horizontal && T != Vertical) {
+      project(rows, count, 1, sc, p);
+    }
+    // one polygon where x is sorted, otherwise a quad per segment
+    auto whole = (!Dynamic && (T == FillLine || T == RangeLine) &&
+                  count >= 2 && monotonic(p));
+    if (T == FillLine && whole) {
+      auto axis = sc.y(sc.y_axis);
+      auto &lower = projected(1);
+      lower.assign({{p.front().x, axis}, {p.back().x, axis}});
+      fillBetween(trans.with(base.a / 2), p, lower, color, line);
+    }
+    if (T == FillLine && !whole) {
+      auto &canvas = trans.with(base.a / 2);
+      auto axis = sc.y(sc.y_axis);
+      for (size_t i = 1; i < count; i++) {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
+        cv::Point points[4] = {
+            p[i], {p[i].x, axis}, {p[i - 1].x, axis}, p[i - 1]};
+        cv::fillConvexPoly(canvas, static_cast<cv::Point *>(points), 4, at(i),
+                           line);
+      }
+    }
+    if (T == RangeLine) {
+      auto &lo = projected(1);
+      auto &hi = projected(2);
+      project(rows, count, 2, sc, lo);
+      project(rows, count, 3, sc, hi);
+      auto &canvas = trans.with(base.a / 2);
+      if (whole) {
+        fillBetween(canvas, lo, hi, color, line);
+      }
+      for (size_t i = 1; i < count && !whole; i++) {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
+        cv::Point points[4] = {lo[i], hi[i], hi[i - 1], lo[i - 1]};
+        cv::fillConvexPoly(canvas, static_cast<cv::Point *>(points), 4, at(i),
+                           line);
+      }
+    }
+    if (T == Line || T == DotLine || T == Dots || T == FillLine ||
+        T == RangeLine) {
+      auto &canvas = trans.with(base);
+      auto packed = (canvas.type() == CV_8UC3);
+      const auto &dot = sprite(2, false, line);
+      auto draw_dot = [&](size_t i) {
+        if (packed) {
+          stamp(canvas, dot, p[i], at(i));
+        } else {
+          cv::circle(canvas, p[i], 2, at(i), 1, line);
+        }
+      };
+      if (T == DotLine || T == Dots) {
+        draw_dot(0);
+      }
+      for (size_t i = 1; i < count; i++) {
+        if (T != Dots) {
+          cv::line(canvas, p[i - 1], p[i], at(i), 1, line);
+        }
+        if (T == DotLine || T == Dots) {
+          draw_dot(i);
+        }
+      }
+    }
+    if (T == Histogram || T == Vistogram) {
+      // bars offset by their index among colliding series, see Figure::draw
+      auto &canvas = trans.with(base);
+      auto u = 2 * sc.unit;
+      auto o = static_cast<int>(2 * u * sc.offset);
+      auto axis = (T == Histogram ? sc.y(sc.y_axis) : sc.x(sc.x_axis));
+      thread_local Bars bars;
+      if (!Dynamic) {
+        bars.reset(T == Histogram ? canvas.cols : canvas.rows);
+      }
+      for (size_t i = 0; i < count; i++) {
+        const auto *r = rows[i];
+        auto at_key = (T == Histogram ? p[i].x : sc.y(r[0])) + o;
+        auto at_value = (T == Histogram ? p[i].y : sc.x(r[1]));
+        if (Dynamic) {
+          if (T == Histogram) {
+            fillBox(canvas, {at_key - u, axis}, {at_key + u, at_value}, at(i));
+          } else {
+            fillBox(canvas, {axis, at_key - u}, {at_value, at_key + u}, at(i));
+          }
+        } else {
+          bars.add(at_key - u, at_key + u, axis, at_value);
+        }
+      }
+      if (!Dynamic) {
+        bars.fill(canvas, T == Histogram, color);
+      }
+    }
+    if (T == Horizontal) {
+      auto &canvas = trans.with(base);
+      auto left = sc.x(sc.x_min);
+      auto right = sc.x(sc.x_max);
+      for (size_t i = 0; i < count; i++) {
+        auto y = sc.y(rows[i][1]);
+        cv::line(canvas, {left, y}, {right, y}, at(i), 1, line);
+      }
+    }
+    if (T == Vertical) {
+      auto &canvas = trans.with(base);
+      auto top = sc.y(sc.y_min);
+      auto bottom = sc.y(sc.y_max);
+      for (size_t i = 0; i < count; i++) {
+        auto x = sc.x(rows[i][1]);
+        cv::line(canvas, {x, top}, {x, bottom}, at(i), 1, line);
+      }
+    }
+    if (T == Range) {
+      auto &b = projected(1);
+      project(rows, count, 2, sc, b);
+      auto &canvas = trans.with(base);
+      for (size_t i = 1; i < count; i++) {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
+        cv::Point points[4] = {p[i], b[i], b[i - 1], p[i - 1]};
+        cv::fillConvexPoly(canvas, static_cast<cv::Point *>(points), 4, at(i),
+                           line);
+      }
+    }
+    if (T == Circle) {
+      auto &canvas = trans.with(base);
+      auto packed = (canvas.type() == CV_8UC3);
+      for (size_t i = 0; i < count; i++) {
+        auto radius = static_cast<int>(rows[i][2]);
+        if (!packed || radius < 0 || radius > max_sprite_radius) {
+          cv::circle(canvas, p[i], radius, at(i), -1, line);
+        } else {
+          stamp(canvas, sprite(radius, true, line), p[i], at(i));
+        }
+      }
+    }
+  }
+};
+
+// Selects the kernel once per draw.
+template <enum Type T>
+void drawKernel(const Series &series, bool dynamic, enum Quality quality,
+                cv::Mat &buffer, const Scale &scale) {
+  if (dynamic) {
+    if (quality == Fast) {
+      Kernel<T, true, Fast>::draw(series, buffer, scale);
+    } else {
+      Kernel<T, true, Smooth>::draw(series, buffer, scale);
+    }
+  } else {
+    if (quality == Fast) {
+      Kernel<T, false, Fast>::draw(series, buffer, scale);
+    } else {
+      Kernel<T, false, Smooth>::draw(series, buffer, scale);
+    }
+  }
+}
+
+}  // namespace cvplot
+
+#endif  // CVPLOT_KERNEL_H
@@ -0,0 +1,206 @@
+#include "cvplot/quantiles.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cvplot {
+
+// Digest
+
+Digest::Digest(double compression)
+    : compression_(std::max(10., compression)),
+      min_(INFINITY),
+      max_(-INFINITY),
+      total_(0.) {}
+
+auto Digest::add(double value, double weight) -> Digest & {
+  if (std::isnan(value) || weight <= 0) {
+    return *this;
+  }
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  buffer_.push_back({value, weight});
+  if (buffer_.size() >= static_cast<size_t>(compression_ * 5)) {
+    compress();
+  }
+  return *this;
+}
+
+auto Digest::merge(const Digest &other) -> Digest & {
+  other.compress();
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  buffer_.insert(buffer_.end(), other.merged_.begin(), other.merged_.end());
+  compress();
+  return *this;
+}
+
+auto Digest::clear() -> Digest & {
+  min_ = INFINITY;
+  max_ = -INFINITY;
+  total_ = 0.;
+  merged_.clear();
+  buffer_.clear();
+  return *this;
+}
+
+auto Digest::count() const -> double {
+  compress();
+  return total_;
+}
+
+auto Digest::min() const -> double { return min_; }
+
+auto Digest::max() const -> double { return max_; }
+
+auto Digest::centroids() const -> size_t {
+  compress();
+  return merged_.size();
+}
+
+// folds the insert buffer into the centroids, using the k1 scale function
+// k(q) = compression / 2pi * asin(2q - 1): a centroid may span at most one
+// unit of k, which keeps the tails accurate and the centroid count bounded
+void Digest::compress() const {
+  if (buffer_.empty()) {
+    return;
+  }
+  buffer_.insert(buffer_.end(), merged_.begin(), merged_.end());
+  std::sort(
+      buffer_.begin(), buffer_.end(),
+      [](const Centroid &a, const Centroid &b) { return a.mean < b.mean; });
+  auto total = 0.;
+  for (const auto &c : buffer_) {
+    total += c.weight;
+  }
+  const auto scale = 2 * std::acos(-1.) / compression_;
+  auto limit = [&](double q) {
+    auto k = std::asin(std::min(1., 2 * q - 1)) / scale + 1;
+    return (k * scale >= std::asin(1.) ? 1. : (std::sin(k * scale) + 1) / 2);
+  };
+  merged_.clear();
+  auto current = buffer_.front();
+  auto cumulative = 0.;
+  auto q_limit = limit(0.) * total;
+  for (auto c = buffer_.begin() + 1; c != buffer_.end(); ++c) {
+    auto proposed = current.weight + c->weight;
+    if (cumulative + proposed <= q_limit) {
+      current.mean += (c->mean - current.mean) * c->weight / proposed;
+      current.weight = proposed;
+    } else {
+      cumulative += current.weight;
+      q_limit = limit(cumulative / total) * total;
+      merged_.push_back(current);
+      current = *c;
+    }
+  }
+  merged_.push_back(current);
+  total_ = total;
+  buffer_.clear();
+}
+
+auto Digest::quantile(double q) const -> double {
+  compress();
+  if (merged_.empty()) {
+    return NAN;
+  }
+  if (merged_.size() == 1) {
+    return merged_.front().mean;
+  }
+  auto index = std::min(1., std::max(0., q)) * total_;
+  auto left = 0.;
+  auto left_mean = min_;
+  auto cumulative = 0.;
+  for (const auto &c : merged_) {
+    auto center = cumulative + c.weight / 2;
+    if (index < center) {
+      auto f = (center > left ? (index - left) / (center - left) : 0.);
+      return left_mean + f * (c.mean - left_mean);
+    }
+    left = center;
+    left_mean = c.mean;
+    cumulative += c.weight;
+  }
+  auto f = (total_ > left ? (index - left) / (total_ - left) : 1.);
+  return left_mean + f * (max_ - left_mean);
+}
+
+// Quantiles
+
+Quantiles::Quantiles(const Quantiles &other)
+    : width_(other.width_),
+      compression_(other.compression_),
+      limit_(other.limit_),
+      buckets_(other.buckets_),
+      last_(buckets_.end()),
+      discard_(other.compression_) {}
+
+auto Quantiles::operator=(const Quantiles &other) -> Quantiles & {
+  width_ = other.width_;
+  compression_ = other.compression_;
+  limit_ = other.limit_;
+  buckets_ = other.buckets_;
+  last_ = buckets_.end();
+  discard_ = Digest(compression_);
+  return *this;
+}
+
+auto Quantiles::add(double time, double value) -> Quantiles & {
+  bucket(time).add(value);
+  return *this;
+}
+
+auto Quantiles::bucket(double time) -> Digest & {
+  auto slot = std::floor(time / width_);
+  // also false for NaN, and keeps the cast below defined
+  if (!(std::abs(slot) < 9e18)) {
+    return discard_.clear();
+  }
+  auto key = static_cast<int64_t>(slot);
+  if (last_ != buckets_.end() && last_->first == key) {
+    return last_->second;
+  }
+  last_ = buckets_.find(key);
+  if (last_ == buckets_.end()) {
+    if (limit_ != 0 && buckets_.size() >= limit_ &&
+        key < buckets_.begin()->first) {
+      // would be the first to go, so it is not kept at all
+      return discard_.clear();
+    }
+    last_ = buckets_.insert({key, Digest(compression_)}).first;
+    if (limit_ != 0 && buckets_.size() > limit_) {
+      buckets_.erase(buckets_.begin());
+    }
+  }
+  return last_->second;
+}
+
+auto Quantiles::merge(const Quantiles &other) -> Quantiles & {
+  for (const auto &b : other.buckets_) {
+    bucket((b.first + .5) * width_).merge(b.second);
+  }
+  return *this;
+}
+
+auto Quantiles::limit(size_t count) -> Quantiles & {
+  limit_ = count;
+  while (limit_ != 0 && buckets_.size() > limit_) {
+    buckets_.erase(buckets_.begin());
+  }
+  last_ = buckets_.end();
+  return *this;
+}
+
+auto Quantiles::clear() -> Quantiles & {
+  buckets_.clear();
+  last_ = buckets_.end();
+  return *this;
+}
+
+auto Quantiles::buckets() const -> const std::map<int64_t, Digest> & {
+  return buckets_;
+}
+
+auto Quantiles::width() const -> double { return width_; }
+
+}  // namespace cvplot
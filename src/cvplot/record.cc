@@ -0,0 +1,209 @@
+#include "cvplot/record.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <thread>
+#include <utility>
+#include <vector>
+#if CV_MAJOR_VERSION >= 3
+#include <opencv2/videoio.hpp>
+#else
+#include <opencv2/highgui/highgui.hpp>
+#endif
+
+#include "internal.h"
+
+namespace cvplot {
+
+struct Recorder::Encoder {
+  std::string filename;
+  double fps;
+  Format format;
+  size_t capacity;
+  Drop drop;
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::condition_variable space;
+  std::deque<cv::Mat> frames;
+  std::vector<cv::Mat> spare;
+  std::thread thread;
+  size_t written{0};
+  size_t dropped{0};
+  size_t copying{0};  // slots taken by pushers copying outside the lock
+  bool closed{false};
+  cv::Size input;  // of the first frame, later ones are scaled to it
+  cv::Size size;   // written, padded to even dimensions for Y4M
+  cv::VideoWriter video;
+  std::ofstream y4m;
+  cv::Mat scaled;
+  cv::Mat padded;
+  cv::Mat yuv;
+
+  Encoder(std::string filename, double fps, Format format, size_t capacity,
+          Drop drop)
+      : filename(std::move(filename)),
+        fps(fps),
+        format(format),
+        capacity(std::max<size_t>(1, capacity)),
+        drop(drop) {}
+
+  void push(const cv::Mat &frame) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (closed) {
+      return;
+    }
+    // the check and taking the slot happen under one lock, so concurrent
+    // pushers never exceed the capacity
+    if (frames.size() + copying >= capacity) {
+      switch (drop) {
+        case DropNewest:
+          dropped++;
+          return;
+        case DropOldest:
+          if (frames.empty()) {  // all slots are still being copied into
+            dropped++;
+            return;
+          }
+          spare.push_back(frames.front());
+          frames.pop_front();
+          dropped++;
+          break;
+        case Block:
+          space.wait(lock, [this] {
+            return frames.size() + copying < capacity || closed;
+          });
+          if (closed) {
+            return;
+          }
+          break;
+      }
+    }
+    copying++;
+    cv::Mat slot;
+    if (!spare.empty()) {
+      slot = spare.back();
+      spare.pop_back();
+    }
+    // copy outside the lock, reusing the slot's storage when sizes match
+    lock.unlock();
+    frame.copyTo(slot);
+    lock.lock();
+    copying--;
+    frames.push_back(slot);
+    ready.notify_one();
+  }
+
+  void run() {
+    for (;;) {
+      std::unique_lock<std::mutex> lock(mutex);
+      // frames still being copied when closing are written too
+      ready.wait(lock, [this] {
+        return (closed && copying == 0) || !frames.empty();
+      });
+      if (frames.empty()) {
+        break;
+      }
+      auto frame = frames.front();
+      frames.pop_front();
+      space.notify_one();
+      lock.unlock();
+      encode(frame);
+      lock.lock();
+      written++;
+      spare.push_back(frame);
+    }
+    video.release();
+    y4m.close();
+  }
+
+  void open(cv::Size frame) {
+    input = frame;
+    if (format == Y4m) {
+      // 4:2:0 chroma needs even dimensions, odd ones get an edge repeated
+      size = {frame.width + frame.width % 2, frame.height + frame.height % 2};
+      y4m.open(filename, std::ios::binary);
+      y4m << "YUV4MPEG2 W" << size.width << " H" << size.height << " F"
+          << static_cast<int>(fps * 1000) << ":1000 Ip A1:1 C420jpeg\n";
+    } else {
+      size = frame;
+#if CV_MAJOR_VERSION >= 3
+      auto fourcc = cv::VideoWriter::fourcc('M', 'J', 'P', 'G');
+#else
+      auto fourcc = CV_FOURCC('M', 'J', 'P', 'G');
+#endif
+      video.open(filename, fourcc, fps, size);
+    }
+  }
+
+  void encode(const cv::Mat &frame) {
+    if (size.width == 0) {
+      open(frame.size());
+    }
+    const auto *f = &frame;
+    if (frame.cols != input.width || frame.rows != input.height) {
+      cv::resize(frame, scaled, input);
+      f = &scaled;
+    }
+    if (input != size) {
+      cv::copyMakeBorder(*f, padded, 0, size.height - input.height, 0,
+                         size.width - input.width, cv::BORDER_REPLICATE);
+      f = &padded;
+    }
+    if (format == Y4m) {
+      cv::cvtColor(*f, yuv, cv::COLOR_BGR2YUV_I420);
+      y4m << "FRAME\n";
+      y4m.write(reinterpret_cast<const char *>(yuv.data),
+                static_cast<std::streamsize>(yuv.total() * yuv.elemSize()));
+    } else if (video.isOpened()) {
+      video.write(*f);
+    }
+  }
+};
+
+Recorder::Recorder(const std::string &filename, double fps, Format format,
+                   size_t capacity, Drop drop)
+    : encoder_(new Encoder(filename, fps, format, capacity, drop)) {
+  encoder_->thread = std::thread(&Encoder::run, encoder_.get());
+}
+
+Recorder::~Recorder() { close(); }
+
+void Recorder::write(const void *frame) {
+  encoder_->push(*static_cast<const cv::Mat *>(frame));
+}
+
+auto Recorder::add(const Figure &figure, Size size) -> Recorder & {
+  cv::Mat mat(cv::Size(size.width, size.height), CV_8UC3);
+  if (figure.drawFit(&mat) != 0) {
+    encoder_->push(mat);
+  }
+  return *this;
+}
+
+void Recorder::close() {
+  {
+    std::lock_guard<std::mutex> lock(encoder_->mutex);
+    encoder_->closed = true;
+  }
+  encoder_->ready.notify_all();
+  encoder_->space.notify_all();
+  if (encoder_->thread.joinable()) {
+    encoder_->thread.join();
+  }
+}
+
+auto Recorder::written() const -> size_t {
+  std::lock_guard<std::mutex> lock(encoder_->mutex);
+  return encoder_->written;
+}
+
+auto Recorder::dropped() const -> size_t {
+  std::lock_guard<std::mutex> lock(encoder_->mutex);
+  return encoder_->dropped;
+}
+
+}  // namespace cvplot
@@ -0,0 +1,350 @@
+#include "cvplot/server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "internal.h"
+
+namespace cvplot {
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+const int send_flags = MSG_NOSIGNAL;
+#else
+const int send_flags = 0;
+#endif
+
+auto sendAll(int socket, const void *data, size_t size) -> bool {
+  const auto *bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    auto sent = send(socket, bytes, size, send_flags);
+    if (sent <= 0) {
+      return false;
+    }
+    bytes += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+auto sendAll(int socket, const std::string &text) -> bool {
+  return sendAll(socket, text.data(), text.size());
+}
+
+auto param(const std::string &query, const std::string &key, double value)
+    -> double {
+  auto pos = ("&" + query).find("&" + key + "=");
+  if (pos == std::string::npos) {
+    return value;
+  }
+  return atof(query.c_str() + pos + key.size() + 1);
+}
+
+}  // namespace
+
+struct Server::Http {
+  typedef std::shared_ptr<const std::vector<uchar>> Jpeg;
+
+  int quality;
+  int listener{-1};
+  int port{0};
+  mutable std::mutex mutex;
+  std::condition_variable frame_ready;
+  std::condition_variable idle;
+  cv::Mat frame;
+  uint64_t sequence{0};
+  std::map<int, Jpeg> jpegs;  // of `sequence`, by scale in percent
+  std::mutex encoding;
+  std::set<int> sockets;
+  std::thread acceptor;
+  size_t active{0};
+  size_t streams{0};
+  size_t encoded{0};
+  size_t readers{0};  // encoders reading `frame` outside the lock
+  bool stop{false};
+
+  explicit Http(int quality) : quality(quality) {}
+
+  // Keeps the latest frame; encoding waits until a client asks for it, so
+  // an idle server only pays for the copy.
+  void push(const cv::Mat &mat) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (readers == 0) {
+      // nobody reads the previous frame, so its storage is reused
+      mat.copyTo(frame);
+    } else {
+      lock.unlock();
+      auto copy = mat.clone();
+      lock.lock();
+      frame = copy;
+    }
+    sequence++;
+    jpegs.clear();
+    frame_ready.notify_all();
+  }
+
+  auto jpeg(int scale, uint64_t &seq) -> Jpeg {
+    // serialized, so concurrent clients wait for one encode instead of
+    // each doing their own
+    std::lock_guard<std::mutex> serial(encoding);
+    cv::Mat source;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      seq = sequence;
+      auto it = jpegs.find(scale);
+      if (it != jpegs.end()) {
+        return it->second;
+      }
+      if (frame.empty()) {
+        return nullptr;
+      }
+      source = frame;
+      readers++;
+    }
+    cv::Mat scaled;
+    if (scale < 100) {
+      cv::resize(source, scaled, cv::Size(), scale / 100., scale / 100.,
+                 cv::INTER_AREA);
+      source = scaled;
+    }
+    auto bytes = std::make_shared<std::vector<uchar>>();
+#if CV_MAJOR_VERSION >= 3
+    auto ok = encode(source, Encoding::jpeg(quality), *bytes);
+#else
+    cv::imencode(".jpg", source, *bytes,
+                 std::vector<int>{CV_IMWRITE_JPEG_QUALITY, quality});
+    auto ok = true;
+#endif
+    std::lock_guard<std::mutex> lock(mutex);
+    readers--;
+    if (!ok) {
+      return nullptr;
+    }
+    encoded++;
+    if (sequence == seq) {
+      jpegs[scale] = bytes;
+    }
+    return bytes;
+  }
+
+  auto listen(const std::string &host, int requested) -> bool {
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+      return false;
+    }
+    auto yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(requested));
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1 ||
+        bind(listener, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) != 0 ||
+        ::listen(listener, 16) != 0) {
+      ::close(listener);
+      listener = -1;
+      return false;
+    }
+    socklen_t length = sizeof(address);
+    getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length);
+    port = ntohs(address.sin_port);
+    return true;
+  }
+
+  void accept() {
+    for (;;) {
+      pollfd p{listener, POLLIN, 0};
+      auto ready = poll(&p, 1, 100);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stop) {
+        return;
+      }
+      if (ready <= 0) {
+        continue;
+      }
+      auto client = ::accept(listener, nullptr, nullptr);
+      if (client < 0) {
+        continue;
+      }
+      timeval timeout{5, 0};
+      setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+      // where send has no MSG_NOSIGNAL, a client hanging up must not raise
+      // SIGPIPE in the host process
+      auto no = 1;
+      setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no, sizeof(no));
+#endif
+      sockets.insert(client);
+      active++;
+      std::thread(&Http::serve, this, client).detach();
+    }
+  }
+
+  void serve(int client) {
+    std::string request;
+    char chunk[1024];  // NOLINT(modernize-avoid-c-arrays)
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < 8192) {
+      auto n = recv(client, chunk, sizeof(chunk), 0);
+      if (n <= 0) {
+        break;
+      }
+      request.append(chunk, static_cast<size_t>(n));
+    }
+    std::string method;
+    std::string target;
+    std::istringstream(request) >> method >> target;
+    auto mark = target.find('?');
+    auto path = target.substr(0, mark);
+    auto query = (mark == std::string::npos ? "" : target.substr(mark + 1));
+    auto scale = std::min(
+        100, std::max(1, static_cast<int>(param(query, "scale", 1) * 100)));
+    if (method != "GET") {
+      sendAll(client, "HTTP/1.0 405 Method Not Allowed\r\n\r\n");
+    } else if (path == "/snapshot") {
+      snapshot(client, scale);
+    } else if (path == "/stream") {
+      stream(client, scale, param(query, "fps", 0));
+    } else {
+      sendAll(client, "HTTP/1.0 404 Not Found\r\n\r\n");
+    }
+    ::close(client);
+    std::lock_guard<std::mutex> lock(mutex);
+    sockets.erase(client);
+    if (--active == 0) {
+      idle.notify_all();
+    }
+  }
+
+  void snapshot(int client, int scale) {
+    uint64_t seq = 0;
+    auto bytes = jpeg(scale, seq);
+    if (!bytes) {
+      sendAll(client, "HTTP/1.0 503 Service Unavailable\r\n\r\n");
+      return;
+    }
+    std::ostringstream header;
+    header << "HTTP/1.0 200 OK\r\nContent-Type: image/jpeg\r\n"
+           << "Content-Length: " << bytes->size() << "\r\n"
+           << "Cache-Control: no-cache\r\nConnection: close\r\n\r\n";
+    if (sendAll(client, header.str())) {
+      sendAll(client, bytes->data(), bytes->size());
+    }
+  }
+
+  void stream(int client, int scale, double fps) {
+    if (!sendAll(client,
+                 "HTTP/1.0 200 OK\r\n"
+                 "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n"
+                 "Cache-Control: no-cache\r\nConnection: close\r\n\r\n")) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    streams++;
+    auto interval = std::chrono::microseconds(
+        fps > 0 ? static_cast<int64_t>(1e6 / fps) : 0);
+    auto next = std::chrono::steady_clock::now();
+    uint64_t last = 0;
+    for (;;) {
+      frame_ready.wait(lock, [&] { return stop || sequence != last; });
+      if (stop) {
+        break;
+      }
+      lock.unlock();
+      auto bytes = jpeg(scale, last);
+      auto sent = true;
+      if (bytes) {
+        std::ostringstream header;
+        header << "--frame\r\nContent-Type: image/jpeg\r\n"
+               << "Content-Length: " << bytes->size() << "\r\n\r\n";
+        sent = sendAll(client, header.str()) &&
+               sendAll(client, bytes->data(), bytes->size()) &&
+               sendAll(client, "\r\n");
+      }
+      lock.lock();
+      if (!sent) {
+        break;
+      }
+      // rate cap: frames arriving before the deadline are skipped
+      next = std::max(next + interval, std::chrono::steady_clock::now());
+      frame_ready.wait_until(lock, next, [this] { return stop; });
+    }
+    streams--;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stop) {
+        return;
+      }
+      stop = true;
+      for (auto s : sockets) {
+        shutdown(s, SHUT_RDWR);
+      }
+    }
+    frame_ready.notify_all();
+    if (acceptor.joinable()) {
+      acceptor.join();
+    }
+    if (listener >= 0) {
+      ::close(listener);
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return active == 0; });
+  }
+};
+
+Server::Server(int port, const std::string &host, int quality)
+    : http_(new Http(quality)) {
+  if (http_->listen(host, port)) {
+    http_->acceptor = std::thread(&Http::accept, http_.get());
+  }
+}
+
+Server::~Server() { close(); }
+
+void Server::write(const void *frame) {
+  http_->push(*static_cast<const cv::Mat *>(frame));
+}
+
+auto Server::add(const Figure &figure, Size size) -> Server & {
+  cv::Mat mat(cv::Size(size.width, size.height), CV_8UC3);
+  if (figure.drawFit(&mat) != 0) {
+    http_->push(mat);
+  }
+  return *this;
+}
+
+void Server::close() { http_->close(); }
+
+auto Server::port() const -> int { return http_->port; }
+
+auto Server::clients() const -> size_t {
+  std::lock_guard<std::mutex> lock(http_->mutex);
+  return http_->streams;
+}
+
+auto Server::encoded() const -> size_t {
+  std::lock_guard<std::mutex> lock(http_->mutex);
+  return http_->encoded;
+}
+
+}  // namespace cvplot
@@ -0,0 +1,189 @@
+#include "cvplot/shared.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include "internal.h"
+
+namespace cvplot {
+
+namespace {
+
+const char magic[8] = "cvplot";  // NOLINT(modernize-avoid-c-arrays)
+const uint32_t version = 2;
+
+auto shmName(const std::string &name) -> std::string {
+  return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+// keeps the start of every slot, and so its pixels, cache-line aligned;
+// rows after the first are aligned only if the stride is
+auto align(size_t bytes) -> size_t { return (bytes + 63) / 64 * 64; }
+
+auto slotAt(void *memory, size_t slot_bytes, uint64_t index)
+    -> SharedRing::Frame * {
+  auto *base =
+      static_cast<uint8_t *>(memory) + align(sizeof(SharedRing::Header));
+  return reinterpret_cast<SharedRing::Frame *>(base + index * slot_bytes);
+}
+
+}  // namespace
+
+SharedRing::SharedRing(const std::string &name, Size max_size, int slots)
+    : name_(shmName(name)),
+      memory_(nullptr),
+      bytes_(0),
+      slot_bytes_(0),
+      max_size_(max_size) {
+  static_assert(sizeof(Frame) == 64, "frame header must fill a cache line");
+  slots = std::max(2, slots);
+  auto pixels = static_cast<size_t>(max_size.width) * max_size.height * 3;
+  slot_bytes_ = align(sizeof(Frame) + pixels);
+  bytes_ = align(sizeof(Header)) + slot_bytes_ * slots;
+  auto fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    return;
+  }
+  if (ftruncate(fd, static_cast<off_t>(bytes_)) != 0) {
+    ::close(fd);
+    shm_unlink(name_.c_str());
+    return;
+  }
+  auto *memory =
+      mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    shm_unlink(name_.c_str());
+    return;
+  }
+  memory_ = memory;
+  std::memset(memory_, 0, align(sizeof(Header)));
+  auto *header = new (memory_) Header();
+  header->version = version;
+  header->slots = static_cast<uint32_t>(slots);
+  header->slot_size = slot_bytes_;
+  header->sequence.store(0, std::memory_order_relaxed);
+  for (auto i = 0; i < slots; i++) {
+    new (slotAt(memory_, slot_bytes_, i)) Frame();
+  }
+  // the magic goes in last, so readers never see a half-initialized header
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, magic, sizeof(magic));
+}
+
+SharedRing::~SharedRing() {
+  if (memory_ != nullptr) {
+    munmap(memory_, bytes_);
+    shm_unlink(name_.c_str());
+  }
+}
+
+void SharedRing::write(const void *frame) {
+  if (memory_ == nullptr) {
+    return;
+  }
+  const auto &mat = *static_cast<const cv::Mat *>(frame);
+  auto *header = static_cast<Header *>(memory_);
+  auto sequence = header->sequence.load(std::memory_order_relaxed) + 1;
+  auto *slot = slotAt(memory_, slot_bytes_, sequence % header->slots);
+  // frames larger than the ring were sized for are cropped
+  auto width = std::min(mat.cols, max_size_.width);
+  auto height = std::min(mat.rows, max_size_.height);
+  auto stride = static_cast<size_t>(width) * 3;
+  slot->sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  auto *pixels = const_cast<uint8_t *>(slot->pixels());
+  for (auto y = 0; y < height; y++) {
+    std::memcpy(pixels + y * stride, mat.ptr(y), stride);
+  }
+  slot->width = static_cast<uint32_t>(width);
+  slot->height = static_cast<uint32_t>(height);
+  slot->stride = static_cast<uint32_t>(stride);
+  slot->channels = 3;
+  slot->size = stride * height;
+  slot->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count();
+  slot->sequence.store(sequence, std::memory_order_release);
+  header->sequence.store(sequence, std::memory_order_release);
+}
+
+auto SharedRing::valid() const -> bool { return memory_ != nullptr; }
+
+auto SharedRing::sequence() const -> uint64_t {
+  if (memory_ == nullptr) {
+    return 0;
+  }
+  return static_cast<const Header *>(memory_)->sequence.load(
+      std::memory_order_acquire);
+}
+
+SharedReader::SharedReader(const std::string &name)
+    : memory_(nullptr), bytes_(0) {
+  auto fd = shm_open(shmName(name).c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < align(sizeof(SharedRing::Header))) {
+    ::close(fd);
+    return;
+  }
+  bytes_ = static_cast<size_t>(info.st_size);
+  auto *memory = mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    return;
+  }
+  const auto *header = static_cast<const SharedRing::Header *>(memory);
+  if (std::memcmp(header->magic, magic, sizeof(magic)) != 0 ||
+      header->version != version) {
+    munmap(memory, bytes_);
+    return;
+  }
+  memory_ = memory;
+}
+
+SharedReader::~SharedReader() {
+  if (memory_ != nullptr) {
+    munmap(const_cast<void *>(memory_), bytes_);
+  }
+}
+
+auto SharedReader::valid() const -> bool { return memory_ != nullptr; }
+
+auto SharedReader::latest(uint64_t &sequence) const
+    -> const SharedRing::Frame * {
+  sequence = 0;
+  if (memory_ == nullptr) {
+    return nullptr;
+  }
+  const auto *header = static_cast<const SharedRing::Header *>(memory_);
+  auto latest = header->sequence.load(std::memory_order_acquire);
+  if (latest == 0) {
+    return nullptr;
+  }
+  const auto *slot = slotAt(const_cast<void *>(memory_), header->slot_size,
+                            latest % header->slots);
+  if (slot->sequence.load(std::memory_order_acquire) != latest) {
+    return nullptr;
+  }
+  sequence = latest;
+  return slot;
+}
+
+auto SharedReader::current(const SharedRing::Frame &frame,
+                           uint64_t sequence) const -> bool {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return frame.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+}  // namespace cvplot
@@ -1,8 +1,13 @@
 #include "cvplot/window.h"
 
+#include <algorithm>
+#include <condition_variable>
 #include <ctime>
+#include <functional>
+#include <mutex>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <thread>
 #include <utility>
 
 #include "internal.h"
@@ -12,8 +17,31 @@ namespace cvplot {
 namespace {
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
 std::unique_ptr<Window> shared_window_;
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::mutex shared_window_mutex_;
+
+// Adds the blending of one view draw to `total`. Declared before the draw's
+// Trans, so the final blend in its destructor is counted too.
+class Composing {
+ public:
+  explicit Composing(double &total)
+      : total_(total), start_(Trans::composed()) {}
+  ~Composing() { total_ += Trans::composed() - start_; }
+
+ protected:
+  double &total_;
+  double start_;
+};
 }  // namespace
 
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<size_t> Pool::allocations_{0};
+
+auto Pool::local() -> Pool & {
+  thread_local Pool pool;
+  return pool;
+}
+
 void mouse_callback(int event, int x, int y, int flags, void *window) {
   if (window != nullptr) {
     (static_cast<Window *>(window))->onmouse(event, x, y, flags);
@@ -93,6 +121,7 @@ auto View::textColor() -> Color { return text_color_; }
 auto View::title() -> std::string & { return title_; }
 
 void View::drawRect(Rect rect, Color color) {
+  Composing composing(window_.composed_);
   Trans trans(window_.buffer());
   cv::rectangle(trans.with(color), {rect_.x + rect.x, rect_.y + rect.y},
                 {rect_.x + rect.x + rect.width, rect_.y + rect.y + rect.height},
@@ -109,6 +138,7 @@ void View::drawText(const std::string &text, Offset offset, Color color,
   cv::Size size =
       getTextSize(text, face, scale, static_cast<int>(thickness), &baseline);
   cv::Point org(rect_.x + offset.x, rect_.y + size.height + offset.y);
+  Composing composing(window_.composed_);
   Trans trans(window_.buffer());
   cv::putText(trans.with(color), text, org, face, scale, color2scalar(color),
               static_cast<int>(thickness));
@@ -124,6 +154,8 @@ void View::drawTextShadow(const std::string &text, Offset offset, Color color,
 }
 
 void View::drawFrame(const std::string &title) const {
+  window_.ensure(rect_);
+  Composing composing(window_.composed_);
   Trans trans(window_.buffer());
   cv::rectangle(trans.with(background_color_), {rect_.x, rect_.y},
                 {rect_.x + rect_.width - 1, rect_.y + rect_.height - 1},
@@ -149,12 +181,15 @@ void View::drawImage(const void *image, int alpha) {
     rect_.height = img.rows;
   }
   window_.ensure(rect_);
+  Composing composing(window_.composed_);
   Trans trans(window_.buffer());
   if (img.cols != rect_.width || img.rows != rect_.height) {
-    cv::Mat resized;
+    auto &pool = Pool::local();
+    auto resized = pool.acquire({rect_.width, rect_.height}, img.type());
     cv::resize(img, resized, {rect_.width, rect_.height});
     resized.copyTo(
         trans.with(alpha)({rect_.x, rect_.y, rect_.width, rect_.height}));
+    pool.release(resized);
   } else {
     img.copyTo(
         trans.with(alpha)({rect_.x, rect_.y, rect_.width, rect_.height}));
@@ -163,6 +198,8 @@ void View::drawImage(const void *image, int alpha) {
 }
 
 void View::drawFill(Color background) {
+  window_.ensure(rect_);
+  Composing composing(window_.composed_);
   Trans trans(window_.buffer());
   cv::rectangle(trans.with(background), {rect_.x, rect_.y},
                 {rect_.x + rect_.width - 1, rect_.y + rect_.height - 1},
@@ -177,10 +214,12 @@ auto View::buffer(Rect &rect) -> void * {
 }
 
 void View::finish() {
+  Timer timer;
   if (!frameless_) {
     drawFrame(title_);
   }
   window_.dirty();
+  timer.lap(window_.stats_.finish);
 }
 
 void View::flush() { window_.flush(); }
@@ -205,16 +244,57 @@ void View::hide(bool hidden) {
 
 // Window
 
-Window::Window(std::string title)
+// Triple buffered hand-off to the UI thread: flush copies the canvas into
+// `back` and swaps it with `next`, the UI thread swaps `next` with `front`
+// and shows that. Storage cycles between the three, so nothing allocates.
+// All HighGUI calls go through `commands`, and mouse events are routed by
+// `targets`, a copy of the views taken with each frame, so the UI thread
+// never touches state the drawing thread changes.
+struct Window::Presenter {
+  struct Target {
+    Rect rect;
+    MouseCallback callback;
+    void *param;
+  };
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  cv::Mat back;
+  cv::Mat next;
+  cv::Mat front;
+  std::string title;
+  bool pending{false};
+  bool stop{false};
+  bool cursor_moved{false};
+  std::chrono::steady_clock::time_point due;  // of `next`, held by fps
+  std::vector<std::function<void()>> commands;
+  std::vector<Target> targets;  // topmost first
+  bool show_cursor{false};
+  std::thread thread;
+  Timing show;
+};
+
+Window::Window(std::string title, bool headless)
     : offset_(0, 0),
       title_(std::move(title)),
+      headless_(headless),
       cursor_(-10, -10),
       name_("cvplot_" + std::to_string(clock())) {
-  cv::namedWindow(name_, cv::WINDOW_AUTOSIZE);
-  cv::setMouseCallback(name_, mouse_callback, this);
+  if (!headless_) {
+    create();
+  }
 }
 
-Window::~Window() { cv::setMouseCallback(name_, mouse_callback, nullptr); }
+Window::~Window() {
+  async(false);
+  if (!headless_) {
+    cv::setMouseCallback(name_, mouse_callback, nullptr);
+  }
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  delete static_cast<cv::Mat *>(buffer_);
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  delete static_cast<cv::Mat *>(storage_);
+}
 
 auto Window::buffer() -> void * { return buffer_; }
 
@@ -225,27 +305,75 @@ auto Window::resize(Rect rect) -> Window & {
 }
 
 auto Window::size(Size size) -> Window & {
-  auto &buffer = *(new cv::Mat(cv::Size(size.width, size.height), CV_8UC3,
-                               color2scalar(Gray)));
-  if (buffer_ != nullptr) {
-    auto &current = *static_cast<cv::Mat *>(buffer_);
-    if (current.cols > 0 && current.rows > 0 && size.width > 0 &&
-        size.height > 0) {
-      cv::Rect inter(0, 0, std::min(current.cols, size.width),
-                     std::min(current.rows, size.height));
-      current(inter).copyTo(buffer(inter));
-    }
-    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
-    delete &current;
+  size = {std::max(0, size.width), std::max(0, size.height)};
+  auto cap = capacity();
+  if (storage_ == nullptr || size.width > cap.width ||
+      size.height > cap.height) {
+    // grow by half at least, so views added one by one don't reallocate
+    // the canvas each time
+    reserve({size.width > cap.width
+                 ? std::max(size.width, cap.width + cap.width / 2)
+                 : cap.width,
+             size.height > cap.height
+                 ? std::max(size.height, cap.height + cap.height / 2)
+                 : cap.height});
+  }
+  auto &storage = *static_cast<cv::Mat *>(storage_);
+  auto &buffer = *static_cast<cv::Mat *>(buffer_);
+  auto cols = std::min(buffer.cols, size.width);
+  auto rows = std::min(buffer.rows, size.height);
+  buffer = storage(cv::Rect(0, 0, size.width, size.height));
+  // storage uncovered by the resize may hold stale pixels
+  if (size.width > cols && rows > 0) {
+    buffer(cv::Rect(cols, 0, size.width - cols, rows))
+        .setTo(color2scalar(Gray));
+  }
+  if (size.height > rows && size.width > 0) {
+    buffer(cv::Rect(0, rows, size.width, size.height - rows))
+        .setTo(color2scalar(Gray));
   }
-  buffer_ = &buffer;
   dirty();
   return *this;
 }
 
+auto Window::reserve(Size size) -> Window & {
+  auto cap = capacity();
+  if (storage_ != nullptr && size.width <= cap.width &&
+      size.height <= cap.height) {
+    return *this;
+  }
+  cap = {std::max(cap.width, size.width), std::max(cap.height, size.height)};
+  cv::Mat storage(cv::Size(cap.width, cap.height), CV_8UC3,
+                  color2scalar(Gray));
+  if (buffer_ == nullptr) {
+    buffer_ = new cv::Mat(storage(cv::Rect(0, 0, 0, 0)));
+    storage_ = new cv::Mat(storage);
+    return *this;
+  }
+  auto &buffer = *static_cast<cv::Mat *>(buffer_);
+  auto region = cv::Rect(0, 0, buffer.cols, buffer.rows);
+  if (region.area() > 0) {
+    buffer.copyTo(storage(region));
+  }
+  *static_cast<cv::Mat *>(storage_) = storage;
+  buffer = storage(region);
+  return *this;
+}
+
+auto Window::capacity() const -> Size {
+  if (storage_ == nullptr) {
+    return {0, 0};
+  }
+  const auto &storage = *static_cast<const cv::Mat *>(storage_);
+  return {storage.cols, storage.rows};
+}
+
 auto Window::offset(Offset offset) -> Window & {
   offset_ = offset;
-  cv::moveWindow(name_, offset.x, offset.y);
+  if (!headless_) {
+    auto name = name_;
+    gui([name, offset] { cv::moveWindow(name, offset.x, offset.y); });
+  }
   return *this;
 }
 
@@ -256,6 +384,52 @@ auto Window::title(const std::string &title) -> Window & {
 
 auto Window::cursor(bool cursor) -> Window & {
   show_cursor_ = cursor;
+  if (presenter_ != nullptr) {
+    std::lock_guard<std::mutex> lock(presenter_->mutex);
+    presenter_->show_cursor = cursor;
+  }
+  return *this;
+}
+
+auto Window::fps(double fps) -> Window & {
+  fps_ = fps;
+  next_frame_ = std::chrono::steady_clock::time_point();
+  return *this;
+}
+
+auto Window::async(bool async) -> Window & {
+  if (async == (presenter_ != nullptr) || headless_) {
+    return *this;
+  }
+  if (async) {
+    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+    presenter_ = new Presenter();
+    presenter_->show_cursor = show_cursor_;
+    target();
+    // the UI thread takes the window over, mouse callbacks included
+    presenter_->thread = std::thread(&Window::run, this);
+    create();
+  } else {
+    {
+      std::lock_guard<std::mutex> lock(presenter_->mutex);
+      presenter_->stop = true;
+    }
+    presenter_->ready.notify_one();
+    presenter_->thread.join();
+    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+    delete presenter_;
+    presenter_ = nullptr;
+  }
+  return *this;
+}
+
+auto Window::addSink(Sink &sink) -> Window & {
+  sinks_.push_back(&sink);
+  return *this;
+}
+
+auto Window::removeSink(Sink &sink) -> Window & {
+  sinks_.erase(std::remove(sinks_.begin(), sinks_.end(), &sink), sinks_.end());
   return *this;
 }
 
@@ -273,48 +447,245 @@ auto Window::ensure(Rect rect) -> Window & {
 }
 
 void Window::onmouse(int event, int x, int y, int flags) {
-  for (auto iter = views_.rbegin(); iter != views_.rend(); ++iter) {
-    auto &view = iter->second;
-    if (view.has({x, y})) {
-      view.onmouse(event, x, y, flags);
-      break;
+  if (presenter_ != nullptr) {
+    // on the UI thread, while views may be changing on the drawing thread
+    Presenter::Target hit{{0, 0, 0, 0}, nullptr, nullptr};
+    auto show_cursor = false;
+    {
+      std::lock_guard<std::mutex> lock(presenter_->mutex);
+      for (const auto &t : presenter_->targets) {
+        if (x >= t.rect.x && y >= t.rect.y && x < t.rect.x + t.rect.width &&
+            y < t.rect.y + t.rect.height) {
+          hit = t;
+          break;
+        }
+      }
+      show_cursor = presenter_->show_cursor;
+    }
+    if (hit.callback != nullptr) {
+      hit.callback(event, x, y, flags, hit.param);
     }
+    cursor_ = {x, y};
+    // the UI thread redraws the cursor itself
+    presenter_->cursor_moved = show_cursor;
+    return;
   }
-  cursor_ = {x, y};
-  if (show_cursor_) {
-    dirty();
-    flush();
+  MouseCallback callback = nullptr;
+  void *param = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(views_mutex_);
+    for (auto iter = views_.rbegin(); iter != views_.rend(); ++iter) {
+      const auto &view = iter->second;
+      if (view.has({x, y})) {
+        callback = view.mouse_callback_;
+        param = view.mouse_param_;
+        break;
+      }
+    }
   }
+  // outside the lock, so callbacks may add views
+  if (callback != nullptr) {
+    callback(event, x, y, flags, param);
+  }
+  // mouse events come far faster than frames, the next flush redraws
+  cursor_ = {x, y};
+  cursor_moved_ = true;
 }
 
 void Window::flush() {
+  if (dirty_ && fps_ > 0) {
+    // with a frame rate cap, flushes within a frame coalesce into one
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_frame_) {
+      // the frame stays dirty for the next flush past the interval; with a
+      // UI thread it is also handed over now, to show once it is due
+      if (presenter_ != nullptr) {
+        hand(next_frame_);
+      }
+      return;
+    }
+    next_frame_ = now + std::chrono::microseconds(
+                            static_cast<int64_t>(1e6 / fps_));
+  }
+  present();
+}
+
+void Window::update() {
+  next_frame_ = std::chrono::steady_clock::time_point();
+  flush();
+}
+
+void Window::present() {
+  Timer timer;
   if (dirty_ && buffer_ != nullptr) {
     auto *b = static_cast<cv::Mat *>(buffer_);
     if (b->cols > 0 && b->rows > 0) {
-      cv::Mat mat;
-      if (show_cursor_) {
-        b->copyTo(mat);
-        cv::line(mat, {cursor_.x - 4, cursor_.y + 1},
-                 {cursor_.x + 6, cursor_.y + 1}, color2scalar(White), 1);
-        cv::line(mat, {cursor_.x + 1, cursor_.y - 4},
-                 {cursor_.x + 1, cursor_.y + 6}, color2scalar(White), 1);
-        cv::line(mat, {cursor_.x - 5, cursor_.y}, {cursor_.x + 5, cursor_.y},
-                 color2scalar(Black), 1);
-        cv::line(mat, {cursor_.x, cursor_.y - 5}, {cursor_.x, cursor_.y + 5},
-                 color2scalar(Black), 1);
-        b = &mat;
+      for (auto *sink : sinks_) {
+        sink->write(b);
       }
-#if CV_MAJOR_VERSION >= 3
-      cv::setWindowTitle(name_, title_);
-#endif
-      cv::imshow(name_, *b);
-      Util::sleep();
+      if (presenter_ != nullptr) {
+        hand(std::chrono::steady_clock::time_point());
+      } else if (!headless_) {
+        show(b, title_, show_cursor_);
+      }
+      timer.lap(stats_.flush);
+      stats_.compose.add(composed_);
+      composed_ = 0;
     }
+  } else if (cursor_moved_ && show_cursor_ && buffer_ != nullptr &&
+             presenter_ == nullptr && !headless_) {
+    // nothing drawn since the last frame shown, which the canvas still holds
+    show(buffer_, title_, true);
   }
+  cursor_moved_ = false;
   dirty_ = false;
 }
 
+void Window::hand(std::chrono::steady_clock::time_point due) {
+  auto &p = *presenter_;
+  static_cast<cv::Mat *>(buffer_)->copyTo(p.back);
+  std::lock_guard<std::mutex> lock(p.mutex);
+  std::swap(p.back, p.next);
+  p.title = title_;
+  p.pending = true;
+  p.due = due;
+  target();
+  p.ready.notify_one();
+}
+
+void Window::target() {
+  auto &targets = presenter_->targets;
+  targets.clear();
+  std::lock_guard<std::mutex> lock(views_mutex_);
+  for (auto iter = views_.rbegin(); iter != views_.rend(); ++iter) {
+    const auto &view = iter->second;
+    targets.push_back({view.rect_, view.mouse_callback_, view.mouse_param_});
+  }
+}
+
+void Window::gui(const std::function<void()> &command) {
+  if (presenter_ == nullptr) {
+    command();
+    return;
+  }
+  std::lock_guard<std::mutex> lock(presenter_->mutex);
+  presenter_->commands.push_back(command);
+  presenter_->ready.notify_one();
+}
+
+void Window::create() {
+  auto name = name_;
+  auto *self = this;
+  gui([name, self] {
+    cv::namedWindow(name, cv::WINDOW_AUTOSIZE);
+    cv::setMouseCallback(name, mouse_callback, self);
+  });
+}
+
+void Window::run() {
+  auto &p = *presenter_;
+  std::string title;
+  std::vector<std::function<void()>> commands;
+  auto show_cursor = false;
+  for (;;) {
+    auto fresh = false;
+    auto stop = false;
+    {
+      std::unique_lock<std::mutex> lock(p.mutex);
+      auto due = [&p] {
+        return p.pending && p.due <= std::chrono::steady_clock::now();
+      };
+      auto until =
+          std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+      if (p.pending) {
+        until = std::min(until, p.due);
+      }
+      p.ready.wait_until(lock, until, [&] {
+        return p.stop || due() || !p.commands.empty();
+      });
+      std::swap(commands, p.commands);
+      show_cursor = p.show_cursor;
+      stop = p.stop;
+      if (!stop && due()) {
+        std::swap(p.next, p.front);
+        title = p.title;
+        p.pending = false;
+        fresh = true;
+      }
+    }
+    for (const auto &command : commands) {
+      command();
+    }
+    commands.clear();
+    if (stop) {
+      break;
+    }
+    if (!p.front.empty() && (fresh || p.cursor_moved)) {
+      p.cursor_moved = false;
+      show(&p.front, title, show_cursor);
+    } else {
+      // keeps the window responsive while no frames arrive
+      Util::sleep();
+    }
+  }
+}
+
+void Window::show(void *buffer, const std::string &title, bool cursor) {
+  auto &b = *static_cast<cv::Mat *>(buffer);
+  auto &pool = Pool::local();
+  // the cursor is drawn onto the frame for imshow only, saving and then
+  // restoring just the patch under it
+  cv::Rect patch(cursor_.x - 5, cursor_.y - 5, 12, 12);
+  patch = patch & cv::Rect(0, 0, b.cols, b.rows);
+  cv::Mat saved;
+  if (cursor && patch.area() > 0) {
+    saved = pool.acquire(patch.size(), b.type());
+    b(patch).copyTo(saved);
+    cv::line(b, {cursor_.x - 4, cursor_.y + 1}, {cursor_.x + 6, cursor_.y + 1},
+             color2scalar(White), 1);
+    cv::line(b, {cursor_.x + 1, cursor_.y - 4}, {cursor_.x + 1, cursor_.y + 6},
+             color2scalar(White), 1);
+    cv::line(b, {cursor_.x - 5, cursor_.y}, {cursor_.x + 5, cursor_.y},
+             color2scalar(Black), 1);
+    cv::line(b, {cursor_.x, cursor_.y - 5}, {cursor_.x, cursor_.y + 5},
+             color2scalar(Black), 1);
+  }
+#if CV_MAJOR_VERSION >= 3
+  cv::setWindowTitle(name_, title);
+#endif
+  Timer timer;
+  cv::imshow(name_, b);
+  if (presenter_ != nullptr) {
+    std::lock_guard<std::mutex> lock(presenter_->mutex);
+    timer.lap(presenter_->show);
+  } else {
+    timer.lap(stats_.show);
+  }
+  if (!saved.empty()) {
+    saved.copyTo(b(patch));
+    pool.release(saved);
+  }
+  Util::sleep();
+}
+
+auto Window::stats() const -> WindowStats {
+  auto stats = stats_;
+  if (presenter_ != nullptr) {
+    std::lock_guard<std::mutex> lock(presenter_->mutex);
+    stats.show = presenter_->show;
+  }
+  return stats;
+}
+
+void Timing::add(double seconds) {
+  last = seconds;
+  average = (count == 0 ? seconds : average + (seconds - average) * 0.1);
+  max = std::max(max, seconds);
+  count++;
+}
+
 auto Window::view(const std::string &name, Size size) -> View & {
+  std::lock_guard<std::mutex> lock(views_mutex_);
   if (views_.count(name) == 0) {
     views_.insert(
         std::map<std::string, View>::value_type(name, View(*this, name, size)));
@@ -327,9 +698,14 @@ void Window::dirty() { dirty_ = true; }
 void Window::hide(bool hidden) {
   if (hidden_ != hidden) {
     hidden_ = hidden;
+    if (headless_) {
+      return;
+    }
     if (hidden) {
-      cv::destroyWindow(name_);
+      auto name = name_;
+      gui([name] { cv::destroyWindow(name); });
     } else {
+      create();
       dirty();
       flush();
     }
@@ -337,23 +713,28 @@ void Window::hide(bool hidden) {
 }
 
 auto Window::current() -> Window & {
+  std::lock_guard<std::mutex> lock(shared_window_mutex_);
   if (shared_window_ == nullptr) {
     shared_window_ = std::unique_ptr<Window>(new Window(""));
   }
   return *shared_window_;
 }
 
-auto Window::current(const std::string &title) -> Window & {
-  shared_window_ = std::unique_ptr<Window>(new Window(title));
+auto Window::current(const std::string &title, bool headless) -> Window & {
+  std::lock_guard<std::mutex> lock(shared_window_mutex_);
+  shared_window_ = std::unique_ptr<Window>(new Window(title, headless));
   return *shared_window_;
 }
 
 void Window::current(Window &window) {
+  std::lock_guard<std::mutex> lock(shared_window_mutex_);
   shared_window_ = std::unique_ptr<Window>(&window);
 }
 
 // Util
 
+auto Util::allocations() -> size_t { return Pool::allocations(); }
+
 void Util::sleep(double seconds) {
   cv::waitKey(std::max(1, static_cast<int>(seconds * 1000)));
 }
@@ -0,0 +1,200 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "cvplot/cvplot.h"
+
+namespace bench {
+
+const int points = 100000;
+const int rounds = 5;
+
+#if CV_MAJOR_VERSION >= 3
+const int line_aa = cv::LINE_AA;
+#else
+const int line_aa = CV_AA;
+#endif
+
+struct Case {
+  const char *name;
+  cvplot::Type type;
+  int depth;
+};
+
+auto uniform() -> double {
+  // NOLINTNEXTLINE
+  return std::rand() / static_cast<double>(RAND_MAX);
+}
+
+void fill(cvplot::Series &series, const Case &c, bool dynamic) {
+  series.clear().type(c.type).dynamicColor(dynamic).reserve(points);
+  if (c.depth == 3 && dynamic) {
+    // four values per entry, only a typed series takes those
+    cvplot::TypedSeries<cvplot::RangeLine, true> typed(series);
+    for (auto i = 0; i < points; i++) {
+      auto v = uniform();
+      typed.add(i, v, v - 1, v + 1, i % 360);
+    }
+    return;
+  }
+  for (auto i = 0; i < points; i++) {
+    auto v = uniform();
+    auto color = static_cast<double>(i % 360);
+    auto second = dynamic ? color : v + 1;
+    switch (c.depth + (dynamic ? 1 : 0)) {
+      case 1:
+        series.add(i, v);
+        break;
+      case 2:
+        series.add(i, {v, c.type == cvplot::Circle ? 2. : second});
+        break;
+      default:
+        series.add(i, {v, dynamic ? v + 1 : v - 1, dynamic ? color : v + 1});
+        break;
+    }
+  }
+}
+
+// nanoseconds per point for one figure draw
+auto measure(cvplot::Figure &figure, cv::Mat &mat) -> double {
+  figure.drawFit(&mat);
+  auto start = std::chrono::steady_clock::now();
+  for (auto r = 0; r < rounds; r++) {
+    figure.drawFit(&mat);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / rounds /
+         points;
+}
+
+// nanoseconds per point for the path the kernels replaced: every point is
+// mapped on its own and handed straight to OpenCV, anti-aliased. It skips
+// axes and blending, so it flatters the old path a little.
+auto baseline(const Case &c, cv::Mat &mat) -> double {
+  std::vector<double> values(points);
+  for (auto &v : values) {
+    v = uniform();
+  }
+  auto xs = (mat.cols - 1.) / points;
+  auto ys = -(mat.rows - 1.) / 3.;
+  auto yd = (mat.rows - 1.) * 2. / 3.;
+  auto x = [&](double v) { return static_cast<int>(v * xs); };
+  auto y = [&](double v) { return static_cast<int>(v * ys + yd); };
+  auto swap = [](const cv::Point &p) { return cv::Point(p.y, p.x); };
+  const cv::Scalar color(255, 128, 0);
+  auto draw = [&] {
+    mat.setTo(cv::Scalar(255, 255, 255));
+    for (auto i = 1; i < points; i++) {
+      auto v = values[i];
+      auto w = values[i - 1];
+      cv::Point a(x(i - 1), y(w));
+      cv::Point b(x(i), y(v));
+      // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
+      cv::Point poly[4] = {b, {b.x, y(0)}, {a.x, y(0)}, a};
+      switch (c.type) {
+        case cvplot::Line:
+          cv::line(mat, a, b, color, 1, line_aa);
+          break;
+        case cvplot::DotLine:
+          cv::line(mat, a, b, color, 1, line_aa);
+          cv::circle(mat, b, 2, color, 1, line_aa);
+          break;
+        case cvplot::Dots:
+          cv::circle(mat, b, 2, color, 1, line_aa);
+          break;
+        case cvplot::FillLine:
+          cv::fillConvexPoly(mat, static_cast<cv::Point *>(poly), 4, color,
+                             line_aa);
+          cv::line(mat, a, b, color, 1, line_aa);
+          break;
+        case cvplot::RangeLine:
+          poly[1].y = y(v + 1), poly[2].y = y(w + 1);
+          poly[0].y = y(v - 1), poly[3].y = y(w - 1);
+          cv::fillConvexPoly(mat, static_cast<cv::Point *>(poly), 4, color,
+                             line_aa);
+          cv::line(mat, a, b, color, 1, line_aa);
+          break;
+        case cvplot::Histogram:
+          cv::rectangle(mat, {b.x - 2, y(0)}, {b.x + 2, b.y}, color, -1,
+                        line_aa);
+          break;
+        case cvplot::Vistogram:
+          cv::rectangle(mat, swap({b.x - 2, y(0)}), swap({b.x + 2, b.y}),
+                        color, -1, line_aa);
+          break;
+        case cvplot::Horizontal:
+          cv::line(mat, {0, b.y}, {mat.cols - 1, b.y}, color, 1, line_aa);
+          break;
+        case cvplot::Vertical:
+          cv::line(mat, swap({0, b.y}), swap({mat.cols - 1, b.y}), color, 1,
+                   line_aa);
+          break;
+        case cvplot::Range:
+          poly[1].y = y(v + 1), poly[2].y = y(w + 1);
+          cv::fillConvexPoly(mat, static_cast<cv::Point *>(poly), 4, color,
+                             line_aa);
+          break;
+        case cvplot::Circle:
+          cv::circle(mat, b, 2, color, -1, line_aa);
+          break;
+      }
+    }
+  };
+  draw();
+  auto start = std::chrono::steady_clock::now();
+  for (auto r = 0; r < rounds; r++) {
+    draw();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / rounds /
+         points;
+}
+
+void run() {
+  const std::vector<Case> cases = {
+      {"Line", cvplot::Line, 1},
+      {"DotLine", cvplot::DotLine, 1},
+      {"Dots", cvplot::Dots, 1},
+      {"FillLine", cvplot::FillLine, 1},
+      {"RangeLine", cvplot::RangeLine, 3},
+      {"Histogram", cvplot::Histogram, 1},
+      {"Vistogram", cvplot::Vistogram, 1},
+      {"Horizontal", cvplot::Horizontal, 1},
+      {"Vertical", cvplot::Vertical, 1},
+      {"Range", cvplot::Range, 2},
+      {"Circle", cvplot::Circle, 2},
+  };
+  cvplot::Window window("bench", true);
+  cv::Mat mat(1000, 1000, CV_8UC3);
+  std::cout << std::left << std::setw(12) << "ns/point" << std::right
+            << std::setw(10) << "baseline" << std::setw(10) << "smooth"
+            << std::setw(10) << "fast" << std::setw(10) << "dynamic"
+            << std::endl;
+  for (const auto &c : cases) {
+    cvplot::Figure figure(window.view(c.name));
+    auto before = baseline(c, mat);
+    auto &series = figure.series("bench");
+    fill(series, c, false);
+    series.quality(cvplot::Smooth);
+    auto smooth = measure(figure, mat);
+    series.quality(cvplot::Fast);
+    auto fast = measure(figure, mat);
+    fill(series, c, true);
+    series.quality(cvplot::Smooth);
+    auto dynamic = measure(figure, mat);
+    std::cout << std::left << std::setw(12) << c.name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10) << before
+              << std::setw(10) << smooth << std::setw(10) << fast
+              << std::setw(10) << dynamic << std::endl;
+  }
+}
+
+}  // namespace bench
+
+auto main(int /*argc*/, char ** /*argv*/) -> int {
+  bench::run();
+  return 0;
+}
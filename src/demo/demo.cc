@@ -77,7 +77,8 @@ void figures() {
   std::vector<std::pair<double, double>> data;
   std::vector<double> values;
 
-  auto window = cvplot::Window("cvplot demo").offset({50, 50});
+  cvplot::Window window("cvplot demo");
+  window.offset({50, 50});
 
   {
     auto &view = window.view("math curves", {300, 300}).offset({0, 0});
@@ -268,7 +269,10 @@ void figures() {
     auto dy = 0.;
     auto f = 0.;
     auto df = 0.;
-    figure.series("random").dynamicColor(true).legend(false);
+    figure.series("random")
+        .dynamicColor(true)
+        .colormap(cvplot::Colormap::viridis(), 0., 100.)
+        .legend(false);
     clock_t time = 0;
     for (int i = 0; i < 1000; i++) {
       auto fps = CLOCKS_PER_SEC / static_cast<double>(clock() - time);
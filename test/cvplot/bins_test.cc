@@ -0,0 +1,71 @@
+#include "cvplot/bins.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace cvplot {
+
+TEST(BinsTest, Fixed) {
+  auto bins = Bins::fixed(10, 0., 10.);
+  bins.add(-1.).add(0.).add(0.5).add(9.99).add(10.).add(NAN);
+  EXPECT_EQ(bins.size(), 10);
+  EXPECT_EQ(bins.count(0), 2U);
+  EXPECT_EQ(bins.count(9), 1U);
+  EXPECT_EQ(bins.underflow(), 1U);
+  EXPECT_EQ(bins.overflow(), 1U);
+  EXPECT_EQ(bins.total(), 5U);
+  EXPECT_DOUBLE_EQ(bins.lower(3), 3.);
+  EXPECT_DOUBLE_EQ(bins.center(3), 3.5);
+}
+
+TEST(BinsTest, Log) {
+  auto bins = Bins::log(3, 1., 1000.);
+  bins.add({0., 2., 20., 200., 500., 2000.});
+  EXPECT_EQ(bins.count(0), 1U);
+  EXPECT_EQ(bins.count(1), 1U);
+  EXPECT_EQ(bins.count(2), 2U);
+  EXPECT_EQ(bins.underflow(), 1U);
+  EXPECT_EQ(bins.overflow(), 1U);
+  EXPECT_NEAR(bins.upper(0), 10., 1e-9);
+  EXPECT_NEAR(bins.center(1), std::sqrt(1000.), 1e-9);
+}
+
+TEST(BinsTest, Auto) {
+  auto bins = Bins::automatic(4);
+  bins.add({0., 1., 2., 3.});
+  EXPECT_EQ(bins.count(0), 1U);
+  EXPECT_EQ(bins.count(3), 1U);
+  bins.add(7.);
+  EXPECT_DOUBLE_EQ(bins.lower(0), 0.);
+  EXPECT_DOUBLE_EQ(bins.upper(3), 8.);
+  EXPECT_EQ(bins.count(0), 2U);
+  EXPECT_EQ(bins.count(1), 2U);
+  EXPECT_EQ(bins.count(3), 1U);
+  bins.add(-1.);
+  EXPECT_DOUBLE_EQ(bins.lower(0), -8.);
+  EXPECT_EQ(bins.count(1), 1U);
+  EXPECT_EQ(bins.count(2), 4U);
+  EXPECT_EQ(bins.count(3), 1U);
+  EXPECT_EQ(bins.total(), 6U);
+}
+
+TEST(BinsTest, Bulk) {
+  std::vector<double> values(1 << 20);
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = static_cast<double>(i % 64);
+  }
+  auto bins = Bins::fixed(64, 0., 64.);
+  bins.add(values);
+  EXPECT_EQ(bins.total(), values.size());
+  for (auto i = 0; i < 64; i++) {
+    EXPECT_EQ(bins.count(i), values.size() / 64);
+  }
+}
+
+}  // namespace cvplot
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,66 @@
+#include "cvplot/colormap.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+
+namespace cvplot {
+
+TEST(ColormapTest, Cos) {
+  const auto &map = Colormap::cos();
+  EXPECT_EQ(map.size(), 4096);
+  EXPECT_TRUE(map.cyclic());
+  for (auto hue : {0., 1., 2.5, 3., 5.9}) {
+    auto a = map.color(hue, 0., 6.);
+    auto b = Color::cos(hue);
+    EXPECT_LE(std::abs(a.r - b.r), 1);
+    EXPECT_LE(std::abs(a.g - b.g), 1);
+    EXPECT_LE(std::abs(a.b - b.b), 1);
+  }
+}
+
+TEST(ColormapTest, Viridis) {
+  const auto &map = Colormap::viridis();
+  EXPECT_EQ(map.size(), 256);
+  auto low = map.color(0.);
+  EXPECT_EQ(low.r, 71);
+  EXPECT_EQ(low.g, 1);
+  EXPECT_EQ(low.b, 85);
+  auto high = map.color(1.);
+  EXPECT_EQ(high.r, 252);
+  EXPECT_EQ(high.g, 231);
+  EXPECT_EQ(high.b, 33);
+}
+
+TEST(ColormapTest, Index) {
+  const auto &map = Colormap::magma();
+  EXPECT_EQ(map.index(-1., 0., 1.), 0);
+  EXPECT_EQ(map.index(2., 0., 1.), 255);
+  EXPECT_EQ(map.index(5., 0., 10.), 128);
+  EXPECT_EQ(map.index(NAN, 0., 1.), 0);
+  EXPECT_EQ(Colormap::cos().index(7.5, 0., 6.), 1024);
+}
+
+TEST(ColormapTest, Map) {
+  const auto &map = Colormap::turbo();
+  std::vector<double> values(1000);
+  for (auto i = 0; i < 1000; i++) {
+    values[i] = i / 999.;
+  }
+  std::vector<Color> colors(500);
+  map.map(values.data(), 500, 2, 0., 1., colors.data());
+  for (auto i = 0; i < 500; i++) {
+    auto c = map.color(values[i * 2]);
+    EXPECT_EQ(colors[i].r, c.r);
+    EXPECT_EQ(colors[i].g, c.g);
+    EXPECT_EQ(colors[i].b, c.b);
+  }
+}
+
+}  // namespace cvplot
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,46 @@
+#include "cvplot/export.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace cvplot {
+
+TEST(ExportTest, Encodings) {
+  Window w("export", true);
+  Figure f(w.view("export"));
+  f.series("test-series").addValue({1., 3., 2., 5., 4.});
+  std::vector<std::string> filenames = {"test/export.png", "test/export.jpg",
+                                        "test/export.ppm", "test/export.bmp"};
+  std::vector<Encoding> encodings = {Encoding::png(1), Encoding::jpeg(80),
+                                     Encoding::ppm(), Encoding::bmp()};
+  std::vector<std::future<bool>> results;
+  {
+    Exporter exporter(2, 2);
+    for (size_t i = 0; i < filenames.size(); i++) {
+      results.push_back(
+          exporter.add(f, filenames[i], {200, 100}, encodings[i]));
+    }
+    exporter.wait();
+  }
+  for (size_t i = 0; i < filenames.size(); i++) {
+    EXPECT_TRUE(results[i].get());
+    EXPECT_EQ(remove(filenames[i].c_str()), 0);
+  }
+}
+
+TEST(ExportTest, Empty) {
+  Window w("export", true);
+  Figure f(w.view("export"));
+  Exporter exporter(1, 1);
+  EXPECT_FALSE(exporter.add(f, "test/empty.png", {100, 100}).get());
+}
+
+}  // namespace cvplot
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -2,7 +2,43 @@
 
 #include <gtest/gtest.h>
 
+#include <opencv2/core/core.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// Counts heap blocks the size of a scratch canvas or larger, from any
+// library, cv::Mat included. Small blocks for strings and the like are not
+// counted.
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+std::atomic<size_t> large_allocations{0};
+const size_t large_allocation = 16384;
+
+#ifdef __GLIBC__
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size) {
+  if (size >= large_allocation) {
+    large_allocations++;
+  }
+  return __libc_malloc(size);
+}
+
+int posix_memalign(void **memory, size_t alignment, size_t size) {
+  if (size >= large_allocation) {
+    large_allocations++;
+  }
+  *memory = __libc_memalign(alignment, size);
+  return (*memory != nullptr ? 0 : ENOMEM);
+}
+}
+#endif
 
 namespace cvplot {
 
@@ -21,6 +57,326 @@ TEST(FigureTest, File) {
   EXPECT_EQ(remove(filename), 0);
 }
 
+TEST(FigureTest, Bytes) {
+  Window w("bytes", true);
+  Figure f(w.view("bytes"));
+  f.series("test-series").addValue({1., 3., 2., 5., 4.});
+  std::vector<uint8_t> bytes;
+  EXPECT_TRUE(f.drawBytes(bytes, {200, 100}));
+  EXPECT_GT(bytes.size(), 8U);
+  EXPECT_EQ(bytes[1], 'P');
+  EXPECT_TRUE(f.drawBytes(bytes, {200, 100}, Encoding::jpeg()));
+  EXPECT_EQ(bytes[0], 0xff);
+  EXPECT_EQ(bytes[1], 0xd8);
+}
+
+TEST(FigureTest, Raw) {
+  Window w("raw", true);
+  Figure f(w.view("raw"));
+  f.series("test-series").addValue({1., 3., 2., 5., 4.});
+  std::vector<uint8_t> pixels(320 * 100, 7);
+  EXPECT_TRUE(f.drawRaw(pixels.data(), {100, 100}, 320));
+  EXPECT_EQ(pixels[0], 255);
+  EXPECT_EQ(pixels[310], 7);
+  EXPECT_FALSE(Figure(f).clear().drawRaw(pixels.data(), {100, 100}, 320));
+}
+
+TEST(FigureTest, Steady) {
+  Window w("steady", true);
+  w.size({200, 100});
+  Figure f(w.view("steady", {200, 100}));
+  f.series("fill").type(FillLine).color(Red.alpha(100));
+  f.series("fill").addValue({1., 3., 2., 5., 4.});
+  f.show();
+  auto allocations = Util::allocations();
+  auto large = large_allocations.load();
+  for (auto i = 0; i < 10; i++) {
+    f.show();
+  }
+  EXPECT_EQ(Util::allocations(), allocations);
+  EXPECT_EQ(large_allocations.load(), large);
+  // scratch of another depth comes from the pool too, and goes back to it
+  cv::Mat image(50, 50, CV_16UC3, cv::Scalar(1000, 0, 0));
+  auto &v = w.view("image", {80, 80});
+  v.drawImage(&image);
+  allocations = Util::allocations();
+  v.drawImage(&image);
+  EXPECT_EQ(Util::allocations(), allocations);
+}
+
+TEST(FigureTest, Fill) {
+  Window w("fill", true);
+  Figure f(w.view("fill"));
+  f.gridSize(150);
+  f.series("fill").type(FillLine).color(Blue.alpha(100));
+  f.series("fill").addValue({2., 2., 2., 2., 2., 2., 2., 2., 2.});
+  std::vector<uint8_t> pixels(300 * 300 * 3);
+  EXPECT_TRUE(f.drawRaw(pixels.data(), {300, 300}));
+  // one polygon, so no seams blended twice between points
+  const auto *row = &pixels[150 * 300 * 3];
+  for (auto x = 100; x < 250; x++) {
+    EXPECT_EQ(row[x * 3], row[100 * 3]);
+    EXPECT_EQ(row[x * 3 + 2], row[100 * 3 + 2]);
+  }
+  EXPECT_NE(row[100 * 3], row[100 * 3 + 2]);
+}
+
+TEST(FigureTest, Unsorted) {
+  Window w("unsorted", true);
+  Figure f(w.view("unsorted"));
+  // the curve crosses itself, so one even-odd polygon would leave a hole
+  // around (2.3, 1.75)
+  f.series("fill").type(FillLine).color(Blue).legend(false);
+  f.series("fill").add(0, 3.).add(4, 3.).add(1, 1.).add(5, 3.);
+  cv::Mat mat(300, 300, CV_8UC3);
+  // x and y at 40 and -50 pixels per unit, from (50, 250)
+  f.draw(&mat, 0, 5, 0, 4, 4, 0);
+  auto hole = mat.at<cv::Vec3b>(162, 142);
+  EXPECT_NE(hole, cv::Vec3b(255, 255, 255));
+
+  // a single point has no area, and must not draw a line down to the axis
+  Figure g(w.view("single"));
+  g.series("fill").type(FillLine).color(Blue).legend(false).add(2.5, 2.);
+  g.draw(&mat, 0, 5, 0, 4, 1, 0);
+  EXPECT_EQ(mat.at<cv::Vec3b>(225, 150), cv::Vec3b(255, 255, 255));
+}
+
+TEST(FigureTest, Circles) {
+  Window w("circles", true);
+  Figure f(w.view("circles"));
+  f.series("circles").type(Circle).color(Red).legend(false);
+  f.series("circles").add(1, {1., 10.});
+  std::vector<uint8_t> pixels(200 * 200 * 3);
+  EXPECT_TRUE(f.drawRaw(pixels.data(), {200, 200}));
+  auto red = 0;
+  for (size_t i = 0; i < pixels.size(); i += 3) {
+    red += (pixels[i] == 0 && pixels[i + 1] == 0 && pixels[i + 2] == 255);
+  }
+  // the fully covered inside of a disc of radius 10
+  EXPECT_GT(red, 250);
+  EXPECT_LT(red, 330);
+}
+
+TEST(FigureTest, Channels) {
+  Window w("channels", true);
+  Figure f(w.view("channels"));
+  f.series("dots").type(Dots).color(Red).legend(false);
+  f.series("dots").addValue({1., 2., 3.});
+  f.series("circles").type(Circle).color(Red).legend(false);
+  f.series("circles").add(1, {2., 10.});
+  // sprites only blend into BGR, a BGRA canvas takes plain circles
+  cv::Mat mat(200, 200, CV_8UC4, cv::Scalar(0, 0, 0, 0));
+  f.drawFit(&mat);
+  auto red = 0;
+  for (auto y = 0; y < mat.rows; y++) {
+    for (auto x = 0; x < mat.cols; x++) {
+      const auto *p = mat.ptr<uint8_t>(y) + x * 4;
+      red += (p[0] == 0 && p[1] == 0 && p[2] == 255);
+    }
+  }
+  EXPECT_GT(red, 250);
+
+  // bars fill whole pixels of any type
+  Figure bars(w.view("bars"));
+  bars.series("bars").type(Histogram).color(Red).legend(false);
+  bars.series("bars").addValue(std::vector<double>(1000, 1.));
+  bars.drawFit(&mat);
+  const auto *row = mat.ptr<uint8_t>(100);
+  for (auto x = 60; x < 140; x++) {
+    EXPECT_EQ(row[x * 4], 0);
+    EXPECT_EQ(row[x * 4 + 2], 255);
+  }
+}
+
+TEST(FigureTest, Bars) {
+  Window w("bars", true);
+  Figure f(w.view("bars"));
+  f.series("bars").type(Histogram).color(Red).legend(false);
+  f.series("bars").addValue(std::vector<double>(1000, 1.));
+  std::vector<uint8_t> pixels(200 * 200 * 3);
+  EXPECT_TRUE(f.drawRaw(pixels.data(), {200, 200}));
+  // dense bars merge into one solid block, with no blended edges
+  const auto *row = &pixels[100 * 200 * 3];
+  for (auto x = 60; x < 140; x++) {
+    EXPECT_EQ(row[x * 3], 0);
+    EXPECT_EQ(row[x * 3 + 2], 255);
+  }
+}
+
+TEST(FigureTest, Bounds) {
+  Series s("bounds", RangeLine, Black);
+  s.add(1, {2., NAN, 3.}).add(NAN, {-4., 1., NAN});
+  s.add(-2, {0., 5., 1.});
+  auto x_min = 0., x_max = 0., y_min = 0., y_max = 0.;
+  auto n_max = 0, p_max = 0;
+  s.bounds(x_min, x_max, y_min, y_max, n_max, p_max);
+  EXPECT_EQ(x_min, -2);
+  EXPECT_EQ(x_max, 1);
+  EXPECT_EQ(y_min, -4);
+  EXPECT_EQ(y_max, 5);
+  EXPECT_EQ(n_max, 3);
+}
+
+TEST(FigureTest, Stats) {
+  Window w("stats", true);
+  Figure f(w.view("stats"));
+  f.hud(true).series("line").addValue({1., 3., 2.});
+  // filled at half alpha inside the series kernel
+  f.series("fill").type(FillLine).addValue({2., 1., 3.});
+  std::vector<uint8_t> pixels(200 * 200 * 3);
+  EXPECT_TRUE(f.drawRaw(pixels.data(), {200, 200}));
+  EXPECT_TRUE(f.drawRaw(pixels.data(), {200, 200}));
+  const auto &stats = f.stats();
+  EXPECT_EQ(stats.bounds.count, 2);
+  EXPECT_EQ(stats.series.count, 2);
+  EXPECT_EQ(stats.draw.count, 2);
+  EXPECT_GT(stats.draw.last, 0);
+  EXPECT_GE(stats.draw.max, stats.draw.average);
+  EXPECT_GE(stats.draw.last, stats.series.last);
+  EXPECT_EQ(stats.compose.count, 2);
+  EXPECT_GT(stats.compose.last, 0);
+  EXPECT_GE(stats.draw.last, stats.compose.last);
+}
+
+TEST(FigureTest, Handle) {
+  Window w("handle", true);
+  Figure f(w.view("handle"));
+  auto handle = f.handle("first");
+  EXPECT_TRUE(handle.valid());
+  EXPECT_FALSE(SeriesHandle().valid());
+  for (auto i = 0; i < 100; i++) {
+    f.series("series-" + std::to_string(i)).addValue(i);
+  }
+  handle->addValue({1., 3., 2.});
+  EXPECT_EQ(&f.series("first"), &*handle);
+  EXPECT_EQ(&f.series("series-42"), &*f.handle("series-42"));
+  EXPECT_EQ(f.series("first").label(), "first");
+  f.clear();
+  EXPECT_FALSE(handle.valid());
+  SeriesHandle orphan;
+  {
+    Figure g(w.view("handle"));
+    orphan = g.handle("gone");
+    EXPECT_TRUE(orphan.valid());
+    EXPECT_TRUE(Figure(g).handle("copy").valid());
+    EXPECT_TRUE(orphan.valid());
+  }
+  EXPECT_FALSE(orphan.valid());
+}
+
+TEST(FigureTest, Feed) {
+  Window w("feed", true);
+  Figure f(w.view("feed"));
+  auto &s = f.series("feed");
+  auto a = s.feed(1 << 15);
+  auto b = s.feed(64);
+  std::thread ta([&a] {
+    for (auto i = 0; i < 20000; i++) {
+      a->add(i, i * 2.);
+    }
+  });
+  std::thread tb([&b] {
+    for (auto i = 0; i < 20000; i++) {
+      while (!b->add(i, -i * 2.)) {
+      }
+    }
+  });
+  // let b fill up before draining, so its producer has to retry
+  while (b->dropped() == 0) {
+    std::this_thread::yield();
+  }
+  while (s.size() < 40000) {
+    f.drain();
+  }
+  ta.join();
+  tb.join();
+  EXPECT_EQ(s.size(), 40000U);
+  EXPECT_EQ(a->dropped(), 0U);
+  EXPECT_GT(b->dropped(), 0U);
+
+  auto copy = s;
+  b->add(0, 0.);
+  copy.drain();
+  EXPECT_EQ(copy.size(), 40000U);
+  s.drain();
+  EXPECT_EQ(s.size(), 40001U);
+
+  auto small = s.feed(2);
+  EXPECT_TRUE(small->addValue(1.));
+  EXPECT_TRUE(small->addValue(2.));
+  EXPECT_FALSE(small->addValue(3.));
+  EXPECT_EQ(small->dropped(), 1U);
+}
+
+TEST(FigureTest, Registry) {
+  std::vector<std::thread> threads;
+  std::vector<Figure *> figures(8);
+  for (auto t = 0; t < 8; t++) {
+    threads.emplace_back([t, &figures] {
+      for (auto i = 0; i < 1000; i++) {
+        auto &f = figure("registry-" + std::to_string(t % 4));
+        if (i == 0) {
+          figures[t] = &f;
+        }
+        EXPECT_EQ(&f, figures[t]);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  for (auto t = 0; t < 4; t++) {
+    EXPECT_EQ(figures[t], figures[t + 4]);
+    EXPECT_NE(figures[t], figures[(t + 1) % 4]);
+  }
+}
+
+TEST(FigureTest, RegistryViews) {
+  auto &w = Window::current();
+  // new names add views while the window routes the mouse and flushes
+  std::thread creator([] {
+    for (auto i = 0; i < 200; i++) {
+      figure("views-" + std::to_string(i));
+    }
+  });
+  for (auto i = 0; i < 200; i++) {
+    w.onmouse(0, i, i, 0);
+    w.flush();
+  }
+  creator.join();
+  // a corrupted view map would crash or lose views, best seen under tsan
+  auto &f = figure("views-199");
+  EXPECT_EQ(&figure("views-199"), &f);
+}
+
+TEST(FigureTest, Ranges) {
+  struct Sample {
+    float time;
+    double value;
+  };
+  Series s("ranges", Line, Red);
+  s.reserve(8);
+  const float floats[] = {1.f, 2.f};  // NOLINT(modernize-avoid-c-arrays)
+  s.addValueRange(floats, floats + 2);
+  s.addValues(std::vector<int>{3, 4});
+  std::vector<Sample> samples = {{10.f, -1.}, {11.f, 5.}};
+  s.addRange(samples.begin(), samples.end(), [](const Sample &sample) {
+    return std::make_pair(sample.time, sample.value);
+  });
+  EXPECT_EQ(s.size(), 6U);
+  double x_min = 0, x_max = 0, y_min = 0, y_max = 0;
+  int n_max = 0, p_max = 0;
+  s.bounds(x_min, x_max, y_min, y_max, n_max, p_max);
+  EXPECT_EQ(x_max, 11.);
+  EXPECT_EQ(y_min, -1.);
+  EXPECT_EQ(y_max, 5.);
+  Series p("points", Dots, Red);
+  p.addValues(samples, [](const Sample &sample) {
+    return Point2(sample.value, sample.time);
+  });
+  EXPECT_EQ(p.size(), 2U);
+}
+
 }  // namespace cvplot
 
 auto main(int argc, char **argv) -> int {
@@ -0,0 +1,59 @@
+#include "cvplot/quantiles.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace cvplot {
+
+TEST(QuantilesTest, Digest) {
+  Digest digest;
+  for (auto i = 0; i < 100000; i++) {
+    digest.add((i * 7919) % 100000);
+  }
+  EXPECT_DOUBLE_EQ(digest.count(), 100000.);
+  EXPECT_DOUBLE_EQ(digest.min(), 0.);
+  EXPECT_DOUBLE_EQ(digest.max(), 99999.);
+  EXPECT_NEAR(digest.quantile(.5), 50000., 500.);
+  EXPECT_NEAR(digest.quantile(.99), 99000., 100.);
+  EXPECT_NEAR(digest.quantile(.999), 99900., 20.);
+  EXPECT_LT(digest.centroids(), 200U);
+}
+
+TEST(QuantilesTest, Merge) {
+  Digest a;
+  Digest b;
+  for (auto i = 0; i < 1000; i++) {
+    a.add(i);
+    b.add(i + 1000);
+  }
+  a.merge(b);
+  EXPECT_DOUBLE_EQ(a.count(), 2000.);
+  EXPECT_NEAR(a.quantile(.5), 1000., 20.);
+  EXPECT_TRUE(std::isnan(Digest().quantile(.5)));
+}
+
+TEST(QuantilesTest, Buckets) {
+  Quantiles quantiles(10.);
+  for (auto i = 0; i < 100; i++) {
+    quantiles.add(i, i % 10);
+  }
+  EXPECT_EQ(quantiles.buckets().size(), 10U);
+  EXPECT_NEAR(quantiles.bucket(55.).quantile(.5), 4.5, .5);
+  quantiles.limit(3);
+  EXPECT_EQ(quantiles.buckets().size(), 3U);
+  EXPECT_EQ(quantiles.buckets().begin()->first, 7);
+  quantiles.add(5, 1).add(NAN, 1).add(INFINITY, 1);
+  EXPECT_EQ(quantiles.buckets().size(), 3U);
+  EXPECT_EQ(quantiles.buckets().begin()->first, 7);
+  quantiles.add(105, 1);
+  EXPECT_EQ(quantiles.buckets().begin()->first, 8);
+  EXPECT_EQ(quantiles.buckets().rbegin()->first, 10);
+}
+
+}  // namespace cvplot
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,84 @@
+#include "cvplot/record.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace cvplot {
+
+TEST(RecordTest, Y4m) {
+  const auto *filename = "test/record.y4m";
+  {
+    Window w("record", true);
+    Recorder recorder(filename, 10., Recorder::Y4m, 2, Recorder::Block);
+    w.size({101, 50}).addSink(recorder);
+    auto &v = w.view("view", {101, 50});
+    for (auto i = 0; i < 3; i++) {
+      v.drawFill(Color::gray(i * 100));
+      v.flush();
+    }
+    w.removeSink(recorder);
+    recorder.close();
+    EXPECT_EQ(recorder.written(), 3U);
+    EXPECT_EQ(recorder.dropped(), 0U);
+  }
+  std::ifstream file(filename, std::ios::binary);
+  std::stringstream stream;
+  stream << file.rdbuf();
+  auto content = stream.str();
+  EXPECT_EQ(content.find("YUV4MPEG2 W102 H50 F10000:1000"), 0U);
+  auto frame = 6 + 102 * 50 * 3 / 2;
+  EXPECT_EQ(content.size(), content.find('\n') + 1 + 3 * frame);
+  EXPECT_EQ(remove(filename), 0);
+}
+
+TEST(RecordTest, Pad) {
+  const auto *filename = "test/pad.y4m";
+  {
+    Window w("pad", true);
+    Recorder recorder(filename, 10., Recorder::Y4m);
+    w.size({101, 51}).addSink(recorder);
+    auto &v = w.view("view", {101, 51});
+    v.drawFill(Black);
+    v.drawRect({0, 0, 49, 50}, White);  // corners included
+    v.flush();
+    recorder.close();
+  }
+  std::ifstream file(filename, std::ios::binary);
+  std::stringstream stream;
+  stream << file.rdbuf();
+  auto content = stream.str();
+  EXPECT_EQ(content.find("YUV4MPEG2 W102 H52"), 0U);
+  // padded rather than stretched, so the edge stays where it was
+  auto luma = content.find("FRAME\n") + 6;
+  for (auto y = 0; y < 52; y++) {
+    const auto *row = &content[luma + y * 102];
+    EXPECT_GT(static_cast<uint8_t>(row[49]), 220);
+    EXPECT_LT(static_cast<uint8_t>(row[50]), 40);
+    EXPECT_EQ(row[101], row[100]);
+  }
+  EXPECT_EQ(remove(filename), 0);
+}
+
+TEST(RecordTest, DropNewest) {
+  const auto *filename = "test/drop.y4m";
+  Window w("drop", true);
+  Recorder recorder(filename, 10., Recorder::Y4m, 1, Recorder::DropNewest);
+  Figure f(w.view("drop"));
+  f.series("test-series").addValue({1., 3., 2.});
+  for (auto i = 0; i < 100; i++) {
+    recorder.add(f, {64, 64});
+  }
+  recorder.close();
+  EXPECT_EQ(recorder.written() + recorder.dropped(), 100U);
+  EXPECT_EQ(remove(filename), 0);
+}
+
+}  // namespace cvplot
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
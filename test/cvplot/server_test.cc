@@ -0,0 +1,110 @@
+#include "cvplot/server.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace cvplot {
+
+namespace {
+
+auto connectTo(int port) -> int {
+  auto s = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(static_cast<uint16_t>(port));
+  inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+  EXPECT_EQ(
+      connect(s, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+  return s;
+}
+
+// reads until `marker` has been seen `count` times or the peer closes
+auto receive(int s, const std::string &marker, int count) -> std::string {
+  std::string content;
+  char chunk[4096];  // NOLINT(modernize-avoid-c-arrays)
+  for (;;) {
+    auto seen = 0;
+    for (auto pos = content.find(marker); pos != std::string::npos;
+         pos = content.find(marker, pos + 1)) {
+      seen++;
+    }
+    if (seen >= count) {
+      break;
+    }
+    auto n = recv(s, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+      break;
+    }
+    content.append(chunk, static_cast<size_t>(n));
+  }
+  return content;
+}
+
+auto get(int port, const std::string &target) -> std::string {
+  auto s = connectTo(port);
+  auto request = "GET " + target + " HTTP/1.0\r\n\r\n";
+  send(s, request.data(), request.size(), 0);
+  auto content = receive(s, "\r\n\r\n", 1000);
+  close(s);
+  return content;
+}
+
+}  // namespace
+
+TEST(ServerTest, Snapshot) {
+  Server server(0);
+  ASSERT_GT(server.port(), 0);
+  EXPECT_EQ(get(server.port(), "/snapshot").find("HTTP/1.0 503"), 0U);
+  Window w("server", true);
+  w.size({64, 48}).addSink(server);
+  auto &v = w.view("view", {64, 48});
+  v.drawFill(Color::gray(100));
+  v.flush();  // no client yet, kept but not encoded
+  EXPECT_EQ(server.encoded(), 0U);
+  auto first = get(server.port(), "/snapshot");
+  w.removeSink(server);
+  EXPECT_EQ(first.find("HTTP/1.0 200 OK"), 0U);
+  EXPECT_NE(first.find("Content-Type: image/jpeg"), std::string::npos);
+  auto body = first.substr(first.find("\r\n\r\n") + 4);
+  ASSERT_GT(body.size(), 2U);
+  EXPECT_EQ(static_cast<uint8_t>(body[0]), 0xFF);
+  EXPECT_EQ(static_cast<uint8_t>(body[1]), 0xD8);
+  EXPECT_EQ(get(server.port(), "/snapshot"), first);
+  EXPECT_EQ(server.encoded(), 1U);
+  get(server.port(), "/snapshot?scale=0.5");
+  EXPECT_EQ(server.encoded(), 2U);
+  EXPECT_EQ(get(server.port(), "/missing").find("HTTP/1.0 404"), 0U);
+}
+
+TEST(ServerTest, Stream) {
+  Server server(0);
+  Window w("stream", true);
+  Figure f(w.view("stream"));
+  f.series("test-series").addValue({1., 3., 2.});
+  server.add(f, {64, 64});
+  auto s = connectTo(server.port());
+  std::string request = "GET /stream?fps=100 HTTP/1.0\r\n\r\n";
+  send(s, request.data(), request.size(), 0);
+  auto content = receive(s, "--frame", 1);
+  EXPECT_EQ(content.find("HTTP/1.0 200 OK"), 0U);
+  EXPECT_NE(content.find("multipart/x-mixed-replace; boundary=frame"),
+            std::string::npos);
+  server.add(f, {64, 64});
+  content += receive(s, "--frame", 1);
+  EXPECT_EQ(server.clients(), 1U);
+  server.close();
+  EXPECT_EQ(server.clients(), 0U);
+  close(s);
+}
+
+}  // namespace cvplot
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,47 @@
+#include "cvplot/shared.h"
+
+#include <gtest/gtest.h>
+
+namespace cvplot {
+
+TEST(SharedTest, Ring) {
+  SharedRing ring("cvplot_test_ring", {64, 32}, 2);
+  EXPECT_TRUE(ring.valid());
+  SharedReader reader("cvplot_test_ring");
+  EXPECT_TRUE(reader.valid());
+  uint64_t sequence = 0;
+  EXPECT_EQ(reader.latest(sequence), nullptr);
+  Window w("shared", true);
+  w.size({80, 20}).addSink(ring);
+  auto &v = w.view("view", {80, 20});
+  for (auto i = 1; i <= 3; i++) {
+    v.drawFill(Color::gray(i * 50));
+    v.flush();
+  }
+  w.removeSink(ring);
+  EXPECT_EQ(ring.sequence(), 3U);
+  const auto *frame = reader.latest(sequence);
+  ASSERT_NE(frame, nullptr);
+  EXPECT_EQ(sequence, 3U);
+  EXPECT_EQ(frame->width, 64U);
+  EXPECT_EQ(frame->height, 20U);
+  EXPECT_EQ(frame->stride, 64U * 3);
+  EXPECT_EQ(frame->size, 64U * 3 * 20);
+  EXPECT_EQ(frame->pixels()[0], 150);
+  EXPECT_TRUE(reader.current(*frame, sequence));
+}
+
+TEST(SharedTest, Missing) {
+  SharedReader reader("cvplot_missing_ring");
+  EXPECT_FALSE(reader.valid());
+  uint64_t sequence = 1;
+  EXPECT_EQ(reader.latest(sequence), nullptr);
+  EXPECT_EQ(sequence, 0U);
+}
+
+}  // namespace cvplot
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,41 @@
+#include "cvplot/typed.h"
+
+#include <gtest/gtest.h>
+
+namespace cvplot {
+
+TEST(TypedTest, Add) {
+  Window w("typed", true);
+  Figure f(w.view("typed"));
+  TypedSeries<Line> line(f.handle("line"));
+  line.reserve(4).addValue(1.).addValue(3).add(5., 2.f);
+  EXPECT_EQ(line.size(), 3U);
+  f.series("line").addValue(4.);
+  EXPECT_EQ(line.size(), 4U);
+  TypedSeries<RangeLine, true> range(f.series("range"));
+  EXPECT_EQ(range.depth, 4);
+  range.add(0., 1., 0.5, 1.5, 3.).add(1., 2., 1.5, 2.5, 4.);
+  EXPECT_EQ(range.size(), 2U);
+  std::vector<uint8_t> pixels(100 * 100 * 3);
+  EXPECT_TRUE(f.drawRaw(pixels.data(), {100, 100}));
+  range.clear();
+  EXPECT_EQ(range.series().size(), 0U);
+  range.add(2., 1., 0., 2., 5.);
+  EXPECT_EQ(range.size(), 1U);
+}
+
+TEST(TypedTest, Relayout) {
+  Series s("relayout", Line, Red);
+  s.addValue(1., 2.);
+  TypedSeries<Circle> circles(s);
+  EXPECT_EQ(circles.size(), 0U);
+  circles.add(1., 2., 3.);
+  EXPECT_EQ(s.size(), 1U);
+}
+
+}  // namespace cvplot
+
+auto main(int argc, char **argv) -> int {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
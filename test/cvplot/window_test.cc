@@ -2,10 +2,128 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <thread>
+
 namespace cvplot {
 
 TEST(WindowTest, Init) { Window w; }
 
+TEST(WindowTest, Headless) {
+  Window w("headless", true);
+  EXPECT_TRUE(w.headless());
+  w.size({100, 50});
+  auto &v = w.view("view", {100, 50});
+  v.drawFill(Red);
+  v.finish();
+  w.offset({10, 10}).flush();
+  EXPECT_NE(w.buffer(), nullptr);
+}
+
+TEST(WindowTest, Async) {
+  Window w("async");
+  w.async(true).size({40, 30});
+  EXPECT_TRUE(w.async());
+  auto &v = w.view("view", {40, 30});
+  for (auto i = 0; i < 3; i++) {
+    v.drawFill(Color::gray(i * 100));
+    v.flush();
+  }
+  // a frame held by the rate cap still reaches the screen once due
+  w.fps(5);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  auto shown = w.stats().show.count;
+  v.drawFill(Red);
+  v.flush();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  v.drawFill(Blue);
+  v.flush();
+  std::this_thread::sleep_for(std::chrono::milliseconds(400));
+  EXPECT_EQ(w.stats().show.count, shown + 2);
+  // HighGUI calls are queued for the UI thread
+  w.offset({10, 10}).cursor(true).hide();
+  w.view("late", {10, 10});
+  w.hide(false);
+  w.async(false);
+  EXPECT_FALSE(w.async());
+  Window h("headless", true);
+  EXPECT_FALSE(h.async(true).async());
+}
+
+TEST(WindowTest, Reserve) {
+  Window w("reserve", true);
+  w.size({100, 50});
+  auto *buffer = w.buffer();
+  EXPECT_EQ(w.capacity().width, 100);
+  EXPECT_EQ(w.capacity().height, 50);
+  w.view("a", {100, 50}).drawFill(Red);
+  w.ensure({0, 50, 100, 10});
+  EXPECT_EQ(w.capacity().width, 100);
+  EXPECT_EQ(w.capacity().height, 75);
+  w.ensure({0, 60, 100, 10});
+  EXPECT_EQ(w.capacity().height, 75);
+  w.reserve({400, 300});
+  EXPECT_EQ(w.capacity().width, 400);
+  EXPECT_EQ(w.capacity().height, 300);
+  w.size({200, 100}).size({50, 50});
+  EXPECT_EQ(w.capacity().width, 400);
+  EXPECT_EQ(w.buffer(), buffer);
+}
+
+class CountSink : public Sink {
+ public:
+  void write(const void * /*frame*/) override { count++; }
+  int count{0};
+};
+
+TEST(WindowTest, Fps) {
+  Window w("fps", true);
+  CountSink sink;
+  w.size({40, 30}).addSink(sink);
+  auto &v = w.view("view", {40, 30});
+  v.drawFill(Red);
+  v.flush();
+  EXPECT_EQ(sink.count, 1);
+  w.fps(1);
+  for (auto i = 0; i < 10; i++) {
+    v.drawFill(Blue);
+    v.flush();
+  }
+  EXPECT_EQ(sink.count, 2);
+  w.update();
+  EXPECT_EQ(sink.count, 3);
+  w.update();
+  EXPECT_EQ(sink.count, 3);
+  // without a UI thread, a held frame goes out with the next late flush
+  w.fps(20);
+  v.drawFill(Red);
+  v.flush();
+  v.drawFill(Blue);
+  v.flush();
+  EXPECT_EQ(sink.count, 4);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  w.flush();
+  EXPECT_EQ(sink.count, 5);
+}
+
+TEST(WindowTest, Stats) {
+  Window w("stats", true);
+  w.size({40, 30});
+  auto &v = w.view("view", {40, 30});
+  v.drawFill(Red);
+  v.drawText("a", {0, 0}, Black.alpha(100), 10);
+  v.finish();
+  v.flush();
+  v.flush();
+  auto stats = w.stats();
+  EXPECT_EQ(stats.finish.count, 1);
+  EXPECT_EQ(stats.flush.count, 1);
+  EXPECT_EQ(stats.show.count, 0);
+  EXPECT_GE(stats.flush.max, stats.flush.last);
+  EXPECT_EQ(stats.compose.count, 1);
+  EXPECT_GT(stats.compose.last, 0);
+}
+
 }  // namespace cvplot
 
 auto main(int argc, char **argv) -> int {